@@ -0,0 +1,171 @@
+// Host microbenchmarks for the portable firmware modules: pio run -e native -t exec
+//
+// Links commands.cpp (the firmware's command table and handlers), command.cpp, frame.cpp,
+// eventlog.cpp and the header-only board/debounce/pixel code as the firmware builds them;
+// stubs.cpp replaces the LED driver, the scene store and the USB side behind them.
+// One "name value unit" line per result, so two runs diff cleanly.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include "board.h"
+#include "command.h"
+#include "commands.h"
+#include "debounce.h"
+#include "frame.h"
+#include "led.h"
+#include "pixel.h"
+
+static constexpr uint32_t SCAN_TICK_US = 1000;
+
+// keeps the optimizer from dropping a result
+static volatile uint32_t sink = 0;
+
+template <typename F>
+static double nsPerOp(uint32_t ops, F&& f)
+{
+  const auto start = std::chrono::steady_clock::now();
+  for (uint32_t i = 0; i < ops; i++) f(i);
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / ops;
+}
+
+static void report(const char* name, double value, const char* unit)
+{
+  printf("%-28s %12.1f %s\n", name, value, unit);
+}
+
+// --- command parsing: the firmware's own table and handlers, hardware stubbed (stubs.cpp) ---
+
+static void benchCommands()
+{
+  static const char* const lines[] = {
+    "SET_SINGLE B=3 C=00FF00",
+    "SET_ALL C=FF8800",
+    "SET_BRIGHTNESS V=128 B=4",
+    "SET_MANY 0=FF0000 1=00FF00 2=0000FF 3=FFFF00 4=00FFFF 5=FF00FF 6=FFFFFF 7=000000",
+    "LOAD_SCENE",
+  };
+  constexpr uint32_t N = 500000;
+  char buf[256];
+
+  strcpy(buf, "SAVE_SCENE"); // something for LOAD_SCENE to apply
+  sink += (uint32_t)Commands::handleLine(buf);
+
+  for (const char* line : lines) {
+    const size_t len = strlen(line) + 1;
+    const double ns = nsPerOp(N, [&](uint32_t) {
+      memcpy(buf, line, len); // the lexer splits in place
+      sink += (uint32_t)Commands::handleLine(buf);
+    });
+    char name[32];
+    snprintf(name, sizeof(name), "cmd %.*s", (int)strcspn(line, " "), line);
+    report(name, 1e9 / ns, "cmd/s");
+  }
+
+  uint32_t v = 0;
+  report("parseColor24", nsPerOp(N, [&](uint32_t) { sink += Cmd::parseColor24("A1B2C3", &v); }), "ns");
+  report("parseU8Dec", nsPerOp(N, [&](uint32_t) { sink += Cmd::parseU8Dec("217", &v); }), "ns");
+}
+
+// --- scan loop: GPIO levels -> pressed mask -> debouncer, one 1 ms tick per pass ---
+
+static void benchScan()
+{
+  using ButtonDebouncer = Debouncer<DefaultDebounce, DEBOUNCE_US, SCAN_TICK_US, Board::buttonMask>;
+  ButtonDebouncer debouncer;
+  debouncer.reset(0, 0);
+
+  constexpr uint32_t N = 2000000;
+  uint32_t levels = 0xFFFFFFFFu; // active low, nothing pressed
+  uint32_t nowUs = 0;
+  const double ns = nsPerOp(N, [&](uint32_t i) {
+    // every 64 passes one button starts to bounce for a few samples
+    if ((i & 63) < 4) levels ^= 1u << Board::pins[(i >> 6) % Board::buttons];
+    nowUs += SCAN_TICK_US;
+    sink += debouncer.update(Board::pressedFromGpio(levels), nowUs);
+  });
+  report("scan pass", ns, "ns");
+  report("scan per button", ns / Board::buttons, "ns");
+}
+
+// --- LED frame: button colors -> gamma + level -> per-LED block -> WS2812 words, as led.cpp
+// and the PIO driver do it ---
+
+static void benchFramePack()
+{
+  static uint32_t colors[Board::buttons];
+  static uint8_t levels[Board::buttons];
+  static Rgb frame[Board::numLeds];
+  static uint32_t words[Board::numLeds];
+  for (uint8_t b = 0; b < Board::buttons; b++) {
+    colors[b] = 0x102030u * (b + 1);
+    levels[b] = Pixel::scaleVideo((uint8_t)(255 - 16 * b), BRIGHTNESS);
+  }
+
+  constexpr uint32_t N = 200000;
+  const double ns = nsPerOp(N, [&](uint32_t i) {
+    colors[i % Board::buttons] ^= 0x010101u;
+    for (uint8_t b = 0; b < Board::buttons; b++) {
+      sink += Board::fillButton(frame, b, Pixel::shade(colors[b], levels[b], LED_GAMMA));
+    }
+    Pixel::packFrame(frame, Board::numLeds, words);
+    sink += words[i % Board::numLeds];
+  });
+  report("led frame pack", ns, "ns");
+
+  // one full SET_MANY frame through COBS + crc and back
+  uint8_t payload[Frame::MAX_PAYLOAD];
+  for (size_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)(i * 7);
+  uint8_t enc[Frame::maxEncoded(Frame::MAX_PAYLOAD)];
+  uint8_t dec[Frame::MAX_PAYLOAD + 1];
+  size_t encLen = 0;
+  report("frame encode 160B", nsPerOp(N, [&](uint32_t) { sink += encLen = Frame::encode(payload, sizeof(payload), enc); }), "ns");
+  report("frame decode 160B", nsPerOp(N, [&](uint32_t) { sink += Frame::decode(enc, encLen, dec, sizeof(dec)); }), "ns");
+}
+
+// --- EVENTS replay: a full log through the TX ring, half of it still taken by earlier output,
+// with one flush per loop pass ---
+
+extern uint32_t benchTxBytes;
+extern uint32_t benchTxDropped;
+extern uint32_t benchTxEvents;
+
+static bool benchReplay()
+{
+  for (uint32_t i = 0; i < EventLog::SIZE; i++) {
+    EventLog::append((uint8_t)FrameOp::Released, Board::buttons - 1, 0xFFFFFF00u + i);
+  }
+
+  char line[] = "EVENTS SINCE=0";
+  benchTxBytes = 1024;
+  benchTxDropped = 0;
+  benchTxEvents = 0;
+  Commands::handleLine(line);
+  uint32_t passes = 1;
+  while (Commands::replaying()) {
+    benchTxBytes = 0;
+    Commands::poll();
+    passes++;
+  }
+  report("replay events", benchTxEvents, "events");
+  report("replay passes", passes, "passes");
+
+  if (benchTxEvents != EventLog::SIZE || benchTxDropped) {
+    printf("replay dropped %lu writes, sent %lu of %lu events\n", (unsigned long)benchTxDropped,
+           (unsigned long)benchTxEvents, (unsigned long)EventLog::SIZE);
+    return false;
+  }
+  return true;
+}
+
+int main()
+{
+  printf("buttons=%u leds=%u debounce_us=%lu\n", (unsigned)Board::buttons, (unsigned)Board::numLeds,
+         (unsigned long)DEBOUNCE_US);
+  benchCommands();
+  benchScan();
+  benchFramePack();
+  return benchReplay() ? 0 : 1;
+}
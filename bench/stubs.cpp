@@ -0,0 +1,156 @@
+// Host stand-ins for the hardware behind commands.cpp: LED state is kept in plain arrays,
+// saved scenes in memory instead of LittleFS (applying one is the real sceneapply.cpp), and
+// replies are formatted into a model of the 2 KiB TX ring that drops what doesn't fit, like
+// UsbSerial::txAppend_().
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+#include "board.h"
+#include "device.h"
+#include "frame.h"
+#include "led.h"
+#include "scene.h"
+
+// --- Led ---
+
+static uint32_t baseColors[Board::buttons];
+static uint8_t levels[Board::buttons];
+static uint8_t globalBrightness = BRIGHTNESS;
+static bool changed = false;
+
+void Led::init() {}
+const char* Led::driver() { return "stub"; }
+
+void Led::setBrightness(uint8_t brightness)
+{
+  globalBrightness = brightness;
+  changed = true;
+}
+
+void Led::setButtonBrightness(uint8_t button, uint8_t level)
+{
+  if (button >= Board::buttons) return;
+  levels[button] = level;
+  changed = true;
+}
+
+void Led::setLed(uint8_t led, uint32_t color)
+{
+  if (led >= Board::buttons) return;
+  baseColors[led] = color;
+  changed = true;
+}
+
+void Led::setAllLed(uint32_t color)
+{
+  for (uint8_t b = 0; b < Board::buttons; b++) baseColors[b] = color;
+  changed = true;
+}
+
+void Led::setLeds(const uint8_t* buttons, const uint32_t* colors, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++) setLed(buttons ? buttons[i] : i, colors[i]);
+}
+
+void Led::setEffect(uint8_t, const LedEffectSpec&)
+{
+  changed = true;
+}
+
+uint32_t Led::baseColor(uint8_t button) { return button < Board::buttons ? baseColors[button] : 0; }
+uint8_t Led::brightness() { return globalBrightness; }
+uint8_t Led::buttonBrightness(uint8_t button) { return button < Board::buttons ? levels[button] : 0; }
+
+void Led::tick(uint32_t) { changed = false; }
+void Led::flush() { changed = false; }
+void Led::hold(uint32_t) {}
+void Led::release() { changed = false; }
+bool Led::dirty() { return changed; }
+void Led::sync() {}
+
+bool Led::nextDue(uint32_t&)
+{
+  return false;
+}
+
+// --- SceneStore ---
+
+static Scene stored;
+static bool haveStored = false;
+
+bool SceneStore::begin() { return true; }
+
+bool SceneStore::load(Scene& out)
+{
+  if (haveStored) out = stored;
+  return haveStored;
+}
+
+bool SceneStore::save(const Scene& scene)
+{
+  stored = scene;
+  haveStored = true;
+  return true;
+}
+
+bool SceneStore::clear()
+{
+  haveStored = false;
+  return true;
+}
+
+// --- Device ---
+
+static constexpr uint32_t TX_RING_SIZE = 2048; // as in usbserial.cpp
+
+// read and reset by bench_main.cpp; clearing benchTxBytes is the end-of-pass flush
+uint32_t benchTxBytes = 0;   // waiting in the ring
+uint32_t benchTxDropped = 0; // writes that didn't fit
+uint32_t benchTxEvents = 0;  // event lines among the queued ones
+static uint32_t clockUs = 0;
+
+static void txAppend(const char* s, size_t len)
+{
+  if (len > TX_RING_SIZE - benchTxBytes) {
+    benchTxDropped++;
+    return;
+  }
+  benchTxBytes += (uint32_t)len;
+  if (strstr(s, " s=")) benchTxEvents++;
+}
+
+bool Device::framed() { return false; }
+
+void Device::printf(const char* fmt, ...)
+{
+  char buf[256];
+  va_list ap;
+  va_start(ap, fmt);
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  va_end(ap);
+  if (n < 0) return;
+  if ((size_t)n >= sizeof(buf)) n = sizeof(buf) - 1;
+  txAppend(buf, (size_t)n);
+}
+
+void Device::println(const char* s)
+{
+  txAppend(s, strlen(s) + 2);
+}
+
+void Device::writeFrame(const uint8_t*, size_t len)
+{
+  txAppend("", Frame::maxEncoded(len) + 1);
+}
+
+size_t Device::txFree() { return TX_RING_SIZE - benchTxBytes; }
+
+uint32_t Device::nowUs() { return clockUs += 10; }
+
+void Device::rebootToBootloader() {}
+bool Device::trigger(uint16_t, uint32_t) { return false; }
+void Device::printConfig() {}
+void Device::printStats() {}
+void Device::resetStats() {}
@@ -0,0 +1,124 @@
+# actions.py
+from __future__ import annotations
+
+import json
+import queue
+import threading
+from typing import Any, Dict, List, Optional, Tuple
+
+# gcode that must not wait behind a running script; sent as printer.emergency_stop instead
+ESTOP_GCODE = ("M112",)
+
+ActionKey = Tuple[str, int]  # (mcu, button_id)
+
+
+def parse_websocket_message(msg: Any) -> Tuple[str, Optional[Dict[str, Any]]]:
+    payload = json.loads(msg) if isinstance(msg, str) else msg
+    if not isinstance(payload, dict):
+        raise TypeError("websocket_message must be dict or JSON string -> dict")
+    method = payload.get("method")
+    if not method:
+        raise ValueError("websocket_message missing 'method'")
+    return str(method), payload.get("params", None)
+
+
+class ActionScheduler:
+    """
+    Runs button actions against one printer (one Moonraker connection).
+
+    - immediate lane: websocket_message actions and M112 are sent from the caller's thread
+      and never wait for a reply, so an e-stop can't queue behind a G28
+    - gcode lane: one worker per printer runs scripts in press order; a repeat is dropped
+      while the same button still has a script waiting, so held jog buttons don't pile up
+
+    Printers are independent: each gets its own scheduler and therefore its own lane.
+    """
+
+    def __init__(self, ws: Any, name: str = "printer", gcode_timeout: float = 30.0):
+        self.ws = ws
+        self.name = name
+        self._gcode_timeout = float(gcode_timeout)
+
+        self._gcode: "queue.Queue[Optional[Tuple[ActionKey, str]]]" = queue.Queue()
+        self._waiting: Dict[ActionKey, int] = {}  # scripts queued but not started, per button
+        self._lock = threading.Lock()
+        self._messages: Dict[int, Tuple[str, Optional[Dict[str, Any]]]] = {}  # id(button) -> parsed
+        self._thread: Optional[threading.Thread] = None
+
+    def start(self) -> None:
+        if self._thread and self._thread.is_alive():
+            return
+        self._thread = threading.Thread(target=self._gcode_worker, name=f"gcode-{self.name}", daemon=True)
+        self._thread.start()
+
+    def stop(self) -> None:
+        self._gcode.put(None)
+        t = self._thread
+        if t and t.is_alive():
+            t.join(timeout=1.0)
+        self._thread = None
+
+    def submit(self, key: ActionKey, buttons: List[Any], repeat: bool = False) -> None:
+        for b in buttons:
+            msg = getattr(b, "websocket_message", None)
+            if msg:
+                self._send_message(b, msg)
+
+            gc = getattr(b, "gcode", None)
+            if not gc:
+                continue
+            script = str(gc)
+            if script.strip().upper() in ESTOP_GCODE:
+                self._send_now("printer.emergency_stop", None, script.strip())
+                continue
+
+            with self._lock:
+                if repeat and self._waiting.get(key):
+                    continue
+                self._waiting[key] = self._waiting.get(key, 0) + 1
+            self._gcode.put((key, script))
+
+    def _send_message(self, b: Any, msg: Any) -> None:
+        parsed = self._messages.get(id(b))
+        if parsed is None:
+            try:
+                parsed = parse_websocket_message(msg)
+            except Exception as e:
+                print(f"[action] websocket_message failed: {e}", flush=True)
+                return
+            self._messages[id(b)] = parsed
+        method, params = parsed
+        self._send_now(method, params, method)
+
+    def _send_now(self, method: str, params: Optional[Dict[str, Any]], label: str) -> None:
+        if not self.ws.is_connected:
+            print(f"[action] moonraker offline, skipped {label}", flush=True)
+            return
+
+        def done(_result: Any, error: Optional[Any]) -> None:
+            if error is not None:
+                print(f"[action] {label} failed: {error}", flush=True)
+
+        try:
+            self.ws.call_async(method, params=params, cb=done)
+            print(f"[action] sent {label}", flush=True)
+        except Exception as e:
+            print(f"[action] {label} failed: {e}", flush=True)
+
+    def _gcode_worker(self) -> None:
+        while True:
+            item = self._gcode.get()
+            if item is None:
+                return
+            key, script = item
+            with self._lock:
+                self._waiting[key] -= 1
+
+            try:
+                if self.ws.is_connected:
+                    self.ws.send_gcode(script, timeout=self._gcode_timeout)
+                    print(f"[action] gcode sent: {script}", flush=True)
+                else:
+                    print(f"[action] moonraker offline, skipped gcode: {script}", flush=True)
+            except Exception as e:
+                print(f"[action] gcode failed: {e}", flush=True)
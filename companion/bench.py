@@ -0,0 +1,210 @@
+# bench.py - end-to-end latency / throughput benchmark for one hotkey MCU
+#
+#   python bench.py /dev/ttyACM0 [--count 1000] [--buttons 12] [--loopback-button 11]
+#                   [--modes text,binary] [--out result.json] [--baseline old.json]
+#
+# Measures, per protocol mode:
+#   ping_ms        PING -> pong round trip (host clock)
+#   single_cps     one-button color commands per second, sustained until all acked
+#   batch_cps      all-buttons-in-one-command updates per second
+#   press_ms       TRIGGER -> pressed event at the host (needs LOOPBACK_PIN wired to a button)
+#   press_dev_us   same path on the device clock: trigger t= -> pressed t=
+from __future__ import annotations
+
+import argparse
+import json
+import sys
+import threading
+import time
+from typing import Dict, List, Optional
+
+from mcu_serial import McuConnection, McuSpec
+
+
+def percentile(values: List[float], p: float) -> float:
+    """Nearest-rank percentile, p in 0..100."""
+    if not values:
+        return float("nan")
+    s = sorted(values)
+    k = max(0, min(len(s) - 1, int(round(p / 100.0 * len(s) + 0.5)) - 1))
+    return s[k]
+
+
+def summarize(values: List[float]) -> Dict[str, float]:
+    return {
+        "n": len(values),
+        "p50": percentile(values, 50),
+        "p99": percentile(values, 99),
+        "p999": percentile(values, 99.9),
+        "max": max(values) if values else float("nan"),
+    }
+
+
+class Bench:
+    def __init__(self, port: str, baudrate: int, binary: bool, timeout: float):
+        self.conn = McuConnection(McuSpec(name="bench", port=port, baudrate=baudrate, binary=binary))
+        self.conn.verbose = False
+        self.timeout = timeout
+
+        self._cv = threading.Condition()
+        self._pongs: Dict[int, float] = {}  # token -> host arrival
+        self._trigger_dev: Optional[int] = None
+        self._press: Optional[tuple] = None  # (button, host arrival, device t)
+        self._released = threading.Event()
+        self._watch_button = -1
+
+        self.conn.set_pong_callback(self._on_pong)
+        self.conn.set_event_callback(self._on_event)
+
+    def _on_pong(self, token: Optional[int], t_us: int) -> None:
+        now = time.perf_counter()
+        with self._cv:
+            if token is None:
+                self._trigger_dev = t_us
+            else:
+                self._pongs[token] = now
+            self._cv.notify_all()
+
+    def _on_event(self, _mcu: str, kind: str, bid: int, t_us: Optional[int]) -> None:
+        now = time.perf_counter()
+        if bid != self._watch_button:
+            return
+        with self._cv:
+            if kind == "pressed":
+                self._press = (bid, now, t_us)
+                self._cv.notify_all()
+            elif kind == "released":
+                self._released.set()
+
+    def _wait(self, pred) -> bool:
+        with self._cv:
+            return self._cv.wait_for(pred, timeout=self.timeout)
+
+    def start(self) -> None:
+        self.conn.connect()
+        time.sleep(0.3)  # firmware banner / PROTO switch
+        if not self.conn.wait_idle(self.timeout):
+            raise RuntimeError("MCU does not acknowledge commands")
+
+    def stop(self) -> None:
+        self.conn.disconnect()
+
+    def ping(self, count: int) -> List[float]:
+        out: List[float] = []
+        for token in range(count):
+            t0 = time.perf_counter()
+            self.conn.ping(token)
+            if not self._wait(lambda: token in self._pongs):
+                print(f"  ping {token}: timeout", file=sys.stderr)
+                continue
+            out.append((self._pongs.pop(token) - t0) * 1000.0)
+        return out
+
+    def throughput(self, count: int, buttons: int, batch: bool) -> float:
+        colors = ("FF0000", "00FF00", "0000FF", "000000")
+        t0 = time.perf_counter()
+        # every command changes something, otherwise the LED shadow drops it
+        for i in range(count):
+            if batch:
+                c = colors[i % len(colors)]
+                self.conn.color_many([(b, c) for b in range(buttons)])
+            else:
+                self.conn.color_many([(i % buttons, colors[(i // buttons) % len(colors)])])
+        if not self.conn.wait_idle(max(self.timeout, count * 0.01)):
+            print("  throughput: not all commands acknowledged", file=sys.stderr)
+        return count / (time.perf_counter() - t0)
+
+    def press(self, count: int, button: int, pulse_ms: int = 30) -> tuple:
+        host: List[float] = []
+        dev: List[float] = []
+        self._watch_button = button
+        for _ in range(count):
+            with self._cv:
+                self._press = None
+                self._trigger_dev = None
+            self._released.clear()
+
+            t0 = time.perf_counter()
+            self.conn.trigger(pulse_ms)
+            if not self._wait(lambda: self._press is not None and self._trigger_dev is not None):
+                print("  press: timeout (is LOOPBACK_PIN wired to the button?)", file=sys.stderr)
+                break
+            _, arrived, t_us = self._press
+            host.append((arrived - t0) * 1000.0)
+            if t_us is not None:
+                dev.append(float((t_us - self._trigger_dev) & 0xFFFFFFFF))
+            self._released.wait(self.timeout)
+            time.sleep(0.005)
+        return host, dev
+
+
+def run_mode(args, binary: bool) -> Dict[str, object]:
+    b = Bench(args.port, args.baudrate, binary, args.timeout)
+    b.start()
+    try:
+        res: Dict[str, object] = {}
+        res["ping_ms"] = summarize(b.ping(args.count))
+        res["single_cps"] = b.throughput(args.count, args.buttons, batch=False)
+        res["batch_cps"] = b.throughput(max(1, args.count // 4), args.buttons, batch=True)
+        if args.loopback_button is not None:
+            host, dev = b.press(max(1, args.count // 10), args.loopback_button)
+            res["press_ms"] = summarize(host)
+            res["press_dev_us"] = summarize(dev)
+        return res
+    finally:
+        b.stop()
+        time.sleep(0.3)  # let the port settle before the next mode reconnects
+
+
+def print_results(results: Dict[str, Dict[str, object]], baseline: Optional[dict]) -> None:
+    for mode, res in results.items():
+        print(f"== {mode} ==")
+        for key, val in res.items():
+            base = (baseline or {}).get(mode, {}).get(key)
+            if isinstance(val, dict):
+                line = f"  {key:<13} n={val['n']:<5} p50={val['p50']:.3f} p99={val['p99']:.3f} " \
+                       f"p999={val['p999']:.3f} max={val['max']:.3f}"
+                if isinstance(base, dict) and base.get("p99"):
+                    line += f"  (p99 {100.0 * (val['p99'] - base['p99']) / base['p99']:+.1f}% vs baseline)"
+            else:
+                line = f"  {key:<13} {val:.1f}/s"
+                if isinstance(base, (int, float)) and base:
+                    line += f"  ({100.0 * (val - base) / base:+.1f}% vs baseline)"
+            print(line)
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description="Hotkey MCU protocol benchmark")
+    ap.add_argument("port")
+    ap.add_argument("--baudrate", type=int, default=250000)
+    ap.add_argument("--count", type=int, default=1000)
+    ap.add_argument("--buttons", type=int, default=12)
+    ap.add_argument("--loopback-button", type=int, default=None,
+                    help="button input wired to the firmware's LOOPBACK_PIN")
+    ap.add_argument("--modes", default="text,binary")
+    ap.add_argument("--timeout", type=float, default=2.0)
+    ap.add_argument("--out", help="write results as JSON")
+    ap.add_argument("--baseline", help="compare against an earlier --out file")
+    args = ap.parse_args()
+
+    baseline = None
+    if args.baseline:
+        with open(args.baseline, "r", encoding="utf-8") as f:
+            baseline = json.load(f)
+
+    results: Dict[str, Dict[str, object]] = {}
+    for mode in [m.strip() for m in args.modes.split(",") if m.strip()]:
+        if mode not in ("text", "binary"):
+            print(f"unknown mode '{mode}'", file=sys.stderr)
+            return 2
+        results[mode] = run_mode(args, binary=(mode == "binary"))
+
+    print_results(results, baseline)
+    if args.out:
+        with open(args.out, "w", encoding="utf-8") as f:
+            json.dump({"meta": {"count": args.count, "time": time.time()}, **results}, f, indent=2)
+    return 0
+
+
+if __name__ == "__main__":
+    raise SystemExit(main())
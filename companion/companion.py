@@ -1,15 +1,14 @@
 # companion.py
 from __future__ import annotations
 
-import json
-import queue
+import contextlib
 import random
 import signal
 import sys
-import threading
 import time
-from typing import Any, Dict, List, Optional, Tuple
+from typing import Any, Callable, Dict, FrozenSet, List, Optional, Tuple
 
+from actions import ActionScheduler
 from confighelper import load_config, HotkeyConfig
 from mcu_serial import MultiMcuSerial, McuSpec
 
@@ -127,6 +126,42 @@ def build_subscribe_objects(cfg: HotkeyConfig, objects_list: List[str]) -> Dict[
     return want
 
 
+# (object, fields the color is computed from; None = any field)
+Dependency = Tuple[str, Optional[FrozenSet[str]]]
+
+FAN_PREFIXES = ("fan_generic", "heater_fan", "controller_fan", "fan")
+
+
+def button_dependencies(b: Any, pick: Callable[[str], Optional[str]]) -> List[Dependency]:
+    """
+    Moonraker objects/fields LedEngine._desired_for_button() reads for this button, resolved
+    the same way (real name from objects.list, else the lowercase name).
+    """
+    st = str(getattr(b, "led_state", "")).lower()
+
+    def obj(name: str) -> str:
+        return pick(name) or name.lower()
+
+    if st == "homed":
+        return [(obj("toolhead"), frozenset(("homed_axes", "position")))]
+    if st == "output":
+        name = str(_get_attr(b, "led_output") or "").strip()
+        return [(obj(f"output_pin {name.lower()}"), frozenset(("value",)))]
+    if st == "fan":
+        name = str(_get_attr(b, "led_fan") or "").strip().lower()
+        return [(obj(f"{prefix} {name}"), frozenset(("speed", "value", "fan_speed"))) for prefix in FAN_PREFIXES]
+    if st == "heater":
+        heater = str(_get_attr(b, "led_heater", "led_header") or "").strip()
+        return [(obj(heater), frozenset(("power", "temperature")))]
+    if st == "z_tilt":
+        return [(obj("z_tilt"), frozenset(("applied",)))]
+    if st in ("qgl", "quad_gantry_level"):
+        return [(obj("quad_gantry_level"), frozenset(("applied",)))]
+    if st == "bed_mesh":
+        return [(obj("bed_mesh"), frozenset(("profile_name", "mesh_matrix", "probed_matrix")))]
+    return []  # static / unknown: constant color, settled once per subscription
+
+
 class LedEngine:
     """
     Owns "desired LED state" derived from Moonraker data.
@@ -140,14 +175,23 @@ class LedEngine:
 
         self._objects_map: Dict[str, str] = {}  # lower -> real
         self.state: Dict[str, Dict[str, Any]] = {}  # real_object -> fields dict
-
-        self._busy_until: Dict[Tuple[str, int], float] = {}  # (mcu,bid) -> monotonic time
-        self._busy_color: Dict[Tuple[str, int], str] = {}  # (mcu,bid) -> color
-
-        self._last_sent: Dict[Tuple[str, int], str] = {}
+        self._build_dependency_index()
 
     def set_objects_list(self, objects: List[str]) -> None:
         self._objects_map = {o.lower(): o for o in objects}
+        self._build_dependency_index()
+
+    def _build_dependency_index(self) -> None:
+        """object -> [(fields, button)] so a status diff only recomputes the buttons it feeds."""
+        self._dynamic = [
+            b for b in self.cfg.buttons.values()
+            if str(getattr(b, "led_state", "")).lower() not in ("", "static")
+        ]
+        self._deps: Dict[str, List[Tuple[Optional[FrozenSet[str]], int]]] = {}
+        for i, b in enumerate(self._dynamic):
+            for obj, fields in button_dependencies(b, self._find_obj):
+                self._deps.setdefault(obj, []).append((fields, i))
+        self._recompute_all = True  # fresh subscription: settle every button once
 
     def _find_obj(self, key: str) -> Optional[str]:
         return self._objects_map.get(key.lower())
@@ -157,39 +201,31 @@ class LedEngine:
         mcu_cfg = self.cfg.mcus.get(mcu)
         base_busy = _norm_color(getattr(mcu_cfg, "color_busy", "")) if mcu_cfg else ""
         col = ""
+        effect, period = "solid", 800
 
         if btns:
             b = btns[0]
             col = _norm_color(_get_attr(b, "led_busy_color")) or ""
+            effect = _get_attr(b, "led_busy_effect") or "solid"
+            period = int(_get_attr(b, "led_busy_period") or 800)
 
         if not col:
             col = base_busy or "000000"
 
-        self._busy_until[(mcu, bid)] = time.monotonic() + float(hold_s)
-        self._busy_color[(mcu, bid)] = col
-        self._set(mcu, bid, col, reason=f"BUSY hold={hold_s}s")
-
-    def tick(self) -> None:
-        now = time.monotonic()
-        expired = [k for k, t in self._busy_until.items() if now >= t]
-        for k in expired:
-            self._busy_until.pop(k, None)
-            self._busy_color.pop(k, None)
-            mcu, bid = k
-            self._revert_after_busy(mcu, bid)
+        # the firmware overlays the effect and falls back to the current state color by itself
+        print(f"[led] mcu={mcu} bid={bid} -> {effect} {col} (BUSY hold={hold_s}s)", flush=True)
+        self.bus.effect(mcu, bid, effect, col, period_ms=period, duration_ms=int(float(hold_s) * 1000))
 
     def _set(self, mcu: str, bid: int, color: str, reason: str = "") -> None:
         if not color:
             return
-        key = (mcu, bid)
-        if self._last_sent.get(key) == color:
+        # mcu_serial diffs against what the MCU shows; only log what actually goes out
+        if not self.bus.colorSingle(mcu, bid, color):
             return
-        self._last_sent[key] = color
         if reason:
             print(f"[led] mcu={mcu} bid={bid} -> {color} ({reason})", flush=True)
         else:
             print(f"[led] mcu={mcu} bid={bid} -> {color}", flush=True)
-        self.bus.colorSingle(mcu, bid, color)
 
     def _desired_for_button(self, b: Any) -> str:
         mcu_cfg = self.cfg.mcus.get(b.mcu)
@@ -271,7 +307,7 @@ class LedEngine:
             # try common object names
             obj = None
             objname = None
-            for prefix in ("fan_generic", "heater_fan", "controller_fan", "fan"):
+            for prefix in FAN_PREFIXES:
                 key = self._find_obj(f"{prefix} {name.lower()}")
                 if key and key in self.state:
                     objname = key
@@ -344,23 +380,10 @@ class LedEngine:
 
         return inactive
 
-    def _revert_after_busy(self, mcu: str, bid: int) -> None:
-        btns = self.button_index.get(mcu, {}).get(bid, [])
-        mcu_cfg = self.cfg.mcus.get(mcu)
-        base = _norm_color(getattr(mcu_cfg, "color_all", "000000")) if mcu_cfg else "000000"
-
-        if not btns:
-            self._set(mcu, bid, base, reason="revert no cfg -> base")
-            return
-
-        b = btns[0]
-        desired = self._desired_for_button(b)
-        if not desired:
-            desired = base
-        self._set(mcu, bid, desired, reason="revert -> desired(from moonraker/static)")
-
     def on_update(self, changes: Dict[str, Any], eventtime: float) -> None:
-        # merge diffs
+        # merge diffs, collecting the buttons that read any of the changed fields
+        affected = set(range(len(self._dynamic))) if self._recompute_all else set()
+        self._recompute_all = False
         for obj, fields in (changes or {}).items():
             if not isinstance(fields, dict):
                 continue
@@ -368,20 +391,23 @@ class LedEngine:
                 self.state[obj] = {}
             self.state[obj].update(fields)
 
-        # recompute all dynamic buttons (but DO NOT override busy)
-        for b in self.cfg.buttons.values():
-            st = str(getattr(b, "led_state", "")).lower()
-            if not st or st == "static":
-                continue
-
-            key = (b.mcu, int(b.button_id))
-            if key in self._busy_until:
-                # still busy; ignore moonraker update for now
-                continue
+            for needs, i in self._deps.get(obj, []):
+                if needs is None or not needs.isdisjoint(fields):
+                    affected.add(i)
 
+        # a running busy effect stays on top on the device
+        updates = []
+        for i in sorted(affected):
+            b = self._dynamic[i]
             col = self._desired_for_button(b)
-            if col:
-                self._set(b.mcu, int(b.button_id), col, reason=f"dyn {st}")
+            if col and self.bus.ledDiffers(b.mcu, int(b.button_id), col):
+                updates.append((b, col))
+
+        # a printer-wide change (pause, error, heating) flips every panel in the same frame
+        panels = {b.mcu for b, _col in updates}
+        with self.bus.synchronized() if len(panels) > 1 else contextlib.nullcontext():
+            for b, col in updates:
+                self._set(b.mcu, int(b.button_id), col, reason=f"dyn {str(getattr(b, 'led_state', '')).lower()}")
 
 
 def main() -> int:
@@ -393,14 +419,15 @@ def main() -> int:
     cfg: HotkeyConfig = load_config(cfg_path)
 
     specs: Dict[str, McuSpec] = {
-        name: McuSpec(name=name, port=m.serial, baudrate=250000)
+        name: McuSpec(name=name, port=m.serial, baudrate=250000, binary=(m.protocol == "binary"),
+                      hid=m.hid)
         for name, m in cfg.mcus.items()
     }
 
     button_index = build_button_index(cfg)
 
     # serial bus
-    bus = MultiMcuSerial(press_cb=None, startup_delay=0.1)
+    bus = MultiMcuSerial(press_cb=None)
     bus.configure_static_from_config(cfg)
     bus.connect(specs)
 
@@ -436,9 +463,6 @@ def main() -> int:
     signal.signal(signal.SIGINT, request_stop)
     signal.signal(signal.SIGTERM, request_stop)
 
-    # action queue
-    actions: "queue.Queue[Tuple[str, int]]" = queue.Queue()
-
     # printer restart detection state
     klippy_state = "unknown"
     subscribed = False
@@ -462,54 +486,9 @@ def main() -> int:
 
     ws.set_notify_callback(on_notify)
 
-    # actions worker
-    def action_worker() -> None:
-        while not stop["flag"]:
-            try:
-                mcu, bid = actions.get(timeout=0.2)
-            except queue.Empty:
-                continue
-
-            btns = button_index.get(mcu, {}).get(bid, [])
-            for b in btns:
-                # websocket_message
-                msg = getattr(b, "websocket_message", None)
-                if msg:
-                    try:
-                        payload = msg
-                        if isinstance(payload, str):
-                            payload = json.loads(payload)
-                        if not isinstance(payload, dict):
-                            raise TypeError("websocket_message must be dict or JSON string -> dict")
-
-                        method = payload.get("method")
-                        params = payload.get("params", None)
-                        if not method:
-                            raise ValueError("websocket_message missing 'method'")
-
-                        # ID random & jsonrpc are handled by ws.call()
-                        if ws.is_connected:
-                            ws.call(method, params=params, timeout=5.0)
-                            print(f"[action] websocket_message sent method={method}", flush=True)
-                        else:
-                            print(f"[action] moonraker offline, skipped websocket_message method={method}", flush=True)
-
-                    except Exception as e:
-                        print(f"[action] websocket_message failed: {e}", flush=True)
-
-                # gcode
-                gc = getattr(b, "gcode", None)
-                if gc:
-                    try:
-                        if ws.is_connected:
-                            ws.send_gcode(str(gc), timeout=30.0)
-                            print(f"[action] gcode sent: {gc}", flush=True)
-                        else:
-                            print(f"[action] moonraker offline, skipped gcode: {gc}", flush=True)
-                    except Exception as e:
-                        print(f"[action] gcode failed: {e}", flush=True)
-
-    threading.Thread(target=action_worker, name="actions", daemon=True).start()
+    # button actions: e-stop style messages go out at once, gcode in order per printer
+    scheduler = ActionScheduler(ws)
+    scheduler.start()
 
     # press handler
     def on_press(mcu_name: str, button_id: int, _raw: str) -> None:
@@ -523,12 +502,25 @@ def main() -> int:
             bus.colorSingle(mcu_name, button_id, base)
             return
 
-        # set busy color only (no active logic here)
+        # actions first, the busy LED can wait
+        scheduler.submit((mcu_name, button_id), btns)
         engine.press_busy(mcu_name, button_id, hold_s=0.8)
-        actions.put((mcu_name, button_id))
 
     bus.set_press_callback(on_press)
 
+    # device-side release/hold/repeat events; repeat drives jog-while-held buttons
+    def on_event(mcu_name: str, kind: str, button_id: int, t_us: Optional[int]) -> None:
+        if kind == "pressed":
+            return  # handled by on_press
+        print(f"[{mcu_name}] {kind} {button_id}" + ("" if t_us is None else f" t={t_us}us"), flush=True)
+        if kind != "repeat":
+            return
+        btns = button_index.get(mcu_name, {}).get(button_id, [])
+        if btns and getattr(btns[0], "repeat", False):
+            scheduler.submit((mcu_name, button_id), btns, repeat=True)
+
+    bus.set_event_callback(on_event)
+
     # connect moonraker thread (it auto-reconnects)
     try:
         ws.connect(timeout=5.0)
@@ -539,8 +531,6 @@ def main() -> int:
 
     try:
         while not stop["flag"]:
-            engine.tick()
-
             # if websocket down, we can't talk to moonraker
             if not ws.is_connected:
                 subscribed = False
@@ -601,6 +591,7 @@ def main() -> int:
         except Exception:
             pass
         try:
+            scheduler.stop()
             ws.close()
         except Exception:
             pass
@@ -157,6 +157,10 @@ class McuConfig:
     serial: str
     color_all: str = "FF8800"
     color_busy: str = "FFE600"
+    protocol: str = "text"  # text | binary
+    brightness: Optional[int] = None  # 0..255, None = firmware default
+    hid: Optional[str] = None  # hidraw node or "auto" for firmware built with HOTKEY_HID=1
+    saved_scene: bool = False  # keep the startup colors in device flash, skip resending them when they match
 
 
 @dataclass(frozen=True)
@@ -172,6 +176,9 @@ class ButtonConfig:
     led_active_color: Optional[str] = None
     led_inactive_color: Optional[str] = None
     led_busy_color: Optional[str] = None
+    led_busy_effect: str = "solid"  # on-device effect while busy: solid|blink|pulse|breathe
+    led_busy_period: int = 800  # ms per effect cycle
+    led_brightness: Optional[int] = None  # 0..255 on top of the mcu brightness
 
     led_axis: Optional[str] = None
     led_fan: Optional[str] = None
@@ -181,6 +188,7 @@ class ButtonConfig:
     led_threshold: Optional[float] = None  # NOTE: aliases led_threshould typo
 
     gcode: Optional[str] = None
+    repeat: bool = False  # run the action again on every firmware auto-repeat while held
     websocket_message: Optional[Any] = None  # parsed JSON if provided
 
 
@@ -231,12 +239,20 @@ def load_config(path: str | Path) -> HotkeyConfig:
             serial = sec.get("serial", required=True, allow_empty=False)
             color_all = sec.getcolor("color_all", "FF8800")
             color_busy = sec.getcolor("color_busy", "FFE600")
+            protocol = sec.getenum("protocol", ("text", "binary"), "text")
+            brightness = sec.getint("brightness", minval=0, maxval=255) if sec.has("brightness") else None
+            saved_scene = sec.getbool("saved_scene", "false")
+            hid = sec.get("hid") if sec.has("hid") else None
 
             mcus[mcu_name] = McuConfig(
                 name=mcu_name,
                 serial=serial,
                 color_all=color_all,
                 color_busy=color_busy,
+                protocol=protocol,
+                brightness=brightness,
+                hid=hid,
+                saved_scene=saved_scene,
             )
 
         elif low.startswith("button "):
@@ -253,6 +269,9 @@ def load_config(path: str | Path) -> HotkeyConfig:
             led_active_color = sec.getcolor("led_active_color", _UNSET) if sec.has("led_active_color") else None
             led_inactive_color = sec.getcolor("led_inactive_color", _UNSET) if sec.has("led_inactive_color") else None
             led_busy_color = sec.getcolor("led_busy_color", _UNSET) if sec.has("led_busy_color") else None
+            led_busy_effect = sec.getenum("led_busy_effect", ("solid", "blink", "pulse", "breathe", "chase"), "solid")
+            led_busy_period = sec.getint("led_busy_period", 800, minval=1, maxval=65535)
+            led_brightness = sec.getint("led_brightness", minval=0, maxval=255) if sec.has("led_brightness") else None
 
             led_axis = sec.get("led_axis", _UNSET) if sec.has("led_axis") else None
             led_fan = sec.get("led_fan", _UNSET) if sec.has("led_fan") else None
@@ -275,6 +294,7 @@ def load_config(path: str | Path) -> HotkeyConfig:
                 led_threshold = None
 
             gcode = sec.get("gcode", _UNSET) if sec.has("gcode") else None
+            repeat = sec.getbool("repeat", "false")
 
             # websocket_message: if present and non-empty, parse JSON
             websocket_message = None
@@ -293,12 +313,16 @@ def load_config(path: str | Path) -> HotkeyConfig:
                 led_active_color=led_active_color,
                 led_inactive_color=led_inactive_color,
                 led_busy_color=led_busy_color,
+                led_busy_effect=led_busy_effect,
+                led_busy_period=led_busy_period,
+                led_brightness=led_brightness,
                 led_axis=led_axis,
                 led_fan=led_fan,
                 led_output=led_output,
                 led_heater=led_heater,
                 led_threshold=led_threshold,
                 gcode=_strip_quotes(gcode) if gcode is not None else None,
+                repeat=repeat,
                 websocket_message=websocket_message,
             )
 
@@ -1,11 +1,15 @@
 # mcu_serial.py
 from __future__ import annotations
 
+import os
 import queue
+import selectors
 import threading
 import time
+import zlib
+from contextlib import contextmanager
 from dataclasses import dataclass
-from typing import Callable, Dict, List, Optional, Tuple, Union
+from typing import Any, Callable, Dict, FrozenSet, Iterator, List, Optional, Set, Tuple, Union
 
 try:
     import serial  # pyserial
@@ -15,6 +19,62 @@ except Exception as e:  # pragma: no cover
 
 Color = Union[str, int]
 PressCallback = Callable[[str, int, str], None]
+# (mcu, kind, button_id, device time in us or None) with kind pressed|released|held|repeat,
+# or "chord" with the firmware chord index in place of the button id
+EventCallback = Callable[[str, str, int, Optional[int]], None]
+# (mcu, pressed bitmap, device time in us or None), after report(state=True)
+StateCallback = Callable[[str, int, Optional[int]], None]
+# (token, device time in us) for ping(), (None, device time) for trigger()
+PongCallback = Callable[[Optional[int], int], None]
+
+# firmware line buffer is 256 bytes incl. terminator
+MAX_LINE_LEN = 250
+
+# --- binary protocol (firmware src/frame.h) ---
+# wire: COBS(payload | crc8(payload)) 0x00, payload = [op] [seq] [args...] (host -> device)
+OP_SET_SINGLE = 0x10
+OP_SET_ALL = 0x11
+OP_SET_MANY = 0x12
+OP_FLUSH = 0x13
+OP_SET_EFFECT = 0x14
+OP_SET_BRIGHTNESS = 0x15
+OP_REPORT = 0x16
+OP_PING = 0x17
+OP_TRIGGER = 0x18
+OP_SAVE_SCENE = 0x19
+OP_LOAD_SCENE = 0x1A
+OP_CLEAR_SCENE = 0x1B
+OP_EVENT_ACK = 0x1C
+OP_EVENTS = 0x1D
+OP_STAGE = 0x1E
+OP_TEXT = 0x1F
+OP_COMMIT = 0x20
+OP_ACK = 0x80
+OP_PRESSED = 0x81
+OP_RELEASED = 0x82
+OP_HELD = 0x83
+OP_REPEAT = 0x84
+OP_STATE = 0x85
+OP_CHORD = 0x86
+OP_PONG = 0x87
+OP_TRIGGERED = 0x88
+OP_SCENE_INFO = 0x89
+OP_EVENT_INFO = 0x8A
+EVENT_OPS = {OP_PRESSED: "pressed", OP_RELEASED: "released", OP_HELD: "held", OP_REPEAT: "repeat", OP_CHORD: "chord"}
+
+FRAME_STATUS = {0: "OK", 1: "ERR", 2: "UNKNOWN"}
+
+# firmware LedEffect ids
+EFFECTS = {"none": 0, "solid": 1, "blink": 2, "pulse": 3, "breathe": 4, "chase": 5}
+
+# firmware Frame::MAX_PAYLOAD minus op + seq
+MAX_FRAME_ARGS = 158
+
+# first line the firmware prints from onConnect(), which also blanks all LEDs (or shows the saved scene)
+FIRMWARE_BANNER = "Hotkey Companion Firmware"
+
+# firmware BRIGHTNESS default, what a scene saved without SET_BRIGHTNESS holds
+FIRMWARE_BRIGHTNESS = 64
 
 
 def _norm_color(color: Color) -> str:
@@ -31,14 +91,205 @@ def _norm_color(color: Color) -> str:
     return s.upper()
 
 
-def _parse_pressed_line(line: str) -> Optional[int]:
+def crc8(data: bytes) -> int:
+    crc = 0
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray()
+    block = bytearray()
+    for b in data:
+        if b == 0:
+            out.append(len(block) + 1)
+            out.extend(block)
+            block.clear()
+            continue
+        block.append(b)
+        if len(block) == 254:
+            out.append(0xFF)
+            out.extend(block)
+            block.clear()
+    out.append(len(block) + 1)
+    out.extend(block)
+    return bytes(out)
+
+
+def cobs_decode(data: bytes) -> Optional[bytes]:
+    out = bytearray()
+    i = 0
+    n = len(data)
+    while i < n:
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > n:
+            return None
+        block = data[i: i + code - 1]
+        if 0 in block:
+            return None
+        out.extend(block)
+        i += code - 1
+        if code != 0xFF and i < n:
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(payload: bytes) -> bytes:
+    return cobs_encode(payload + bytes([crc8(payload)])) + b"\x00"
+
+
+def decode_frame(raw: bytes) -> Optional[bytes]:
+    """Payload without crc, or None if the frame is broken."""
+    data = cobs_decode(raw)
+    if data is None or len(data) < 2:
+        return None
+    if crc8(data[:-1]) != data[-1]:
+        return None
+    return data[:-1]
+
+
+def _rgb(color: str) -> bytes:
+    return bytes.fromhex(color)
+
+
+def _parse_event_line(line: str) -> Optional[Tuple[str, int, Optional[int], Optional[int]]]:
+    """'pressed 3 t=123456 s=17' -> ('pressed', 3, 123456, 17); older firmware sends less, down to 'pressed 3'"""
+    parts = line.strip().split()
+    if len(parts) < 2:
+        return None
+    kind = parts[0].lower()
+    if kind not in EVENT_OPS.values():
+        return None
+    try:
+        bid = int(parts[1], 10)
+    except ValueError:
+        return None
+
+    t_us: Optional[int] = None
+    seq: Optional[int] = None
+    for extra in parts[2:]:
+        key, _, val = extra.partition("=")
+        if key in ("t", "s"):
+            try:
+                if key == "t":
+                    t_us = int(val, 10)
+                else:
+                    seq = int(val, 10)
+            except ValueError:
+                return None
+    return kind, bid, t_us, seq
+
+
+def _parse_events_line(line: str) -> Optional[Tuple[int, int, int, int]]:
+    """'events next=5 last=9 lost=0 hwm=3' -> (5, 9, 0, 3)"""
     parts = line.strip().split()
-    if len(parts) != 2:
+    if len(parts) != 5 or parts[0] != "events":
         return None
-    if parts[0].lower() != "pressed":
+    vals: Dict[str, int] = {}
+    for extra in parts[1:]:
+        key, _, val = extra.partition("=")
+        try:
+            vals[key] = int(val, 10)
+        except ValueError:
+            return None
+    try:
+        return vals["next"], vals["last"], vals["lost"], vals["hwm"]
+    except KeyError:
+        return None
+
+
+def _parse_state_line(line: str) -> Optional[Tuple[int, Optional[int]]]:
+    """'state 801 t=123456' -> (0x801, 123456)"""
+    parts = line.strip().split()
+    if len(parts) < 2 or parts[0].lower() != "state":
         return None
     try:
-        return int(parts[1], 10)
+        mask = int(parts[1], 16)
+        t_us = None
+        for extra in parts[2:]:
+            key, _, val = extra.partition("=")
+            if key == "t":
+                t_us = int(val, 10)
+    except ValueError:
+        return None
+    return mask, t_us
+
+
+def _parse_pong_line(line: str) -> Optional[Tuple[Optional[int], int]]:
+    """'pong 7 t=123' -> (7, 123); 'trigger t=123' -> (None, 123)"""
+    parts = line.strip().split()
+    try:
+        if len(parts) == 3 and parts[0] == "pong" and parts[2].startswith("t="):
+            return int(parts[1], 10), int(parts[2][2:], 10)
+        if len(parts) == 2 and parts[0] == "trigger" and parts[1].startswith("t="):
+            return None, int(parts[1][2:], 10)
+    except ValueError:
+        pass
+    return None
+
+
+@dataclass(frozen=True)
+class ReadyInfo:
+    """The firmware's READY line, sent right after the banner once onConnect() settled the LEDs."""
+    version: int
+    firmware: str
+    caps: FrozenSet[str]
+    buttons: int
+    frame_hash: int  # scene_crc() of what the LEDs show now
+
+
+def _parse_ready_line(line: str) -> Optional[ReadyInfo]:
+    """'READY v=1 fw=0.0.1 caps=text,bin buttons=12 hash=1a2b3c4d' -> ReadyInfo"""
+    parts = line.strip().split()
+    if not parts or parts[0] != "READY":
+        return None
+    vals = dict(p.partition("=")[::2] for p in parts[1:])
+    try:
+        return ReadyInfo(
+            version=int(vals["v"], 10),
+            firmware=vals.get("fw", ""),
+            caps=frozenset(c for c in vals.get("caps", "").split(",") if c),
+            buttons=int(vals["buttons"], 10),
+            frame_hash=int(vals["hash"], 16),
+        )
+    except (KeyError, ValueError):
+        return None
+
+
+def _parse_scene_line(line: str) -> Optional[Tuple[int, int]]:
+    """'scene buttons=12 crc=1a2b3c4d' -> (12, 0x1a2b3c4d)"""
+    parts = line.strip().split()
+    if len(parts) != 3 or parts[0] != "scene":
+        return None
+    if not parts[1].startswith("buttons=") or not parts[2].startswith("crc="):
+        return None
+    try:
+        return int(parts[1][8:], 10), int(parts[2][4:], 16)
+    except ValueError:
+        return None
+
+
+def scene_crc(brightness: int, colors: List[str], levels: List[int]) -> int:
+    """Firmware SceneStore::crc(): zlib crc32 over brightness, then r g b level per button."""
+    data = bytearray([brightness & 0xFF])
+    for c, level in zip(colors, levels):
+        data += _rgb(c) + bytes([level & 0xFF])
+    return zlib.crc32(bytes(data)) & 0xFFFFFFFF
+
+
+def _parse_reply_line(line: str) -> Optional[Tuple[int, str]]:
+    """'#42 OK' -> (42, 'OK')"""
+    parts = line.strip().split()
+    if len(parts) != 2 or not parts[0].startswith("#"):
+        return None
+    if parts[1] not in ("OK", "ERR", "UNKNOWN"):
+        return None
+    try:
+        return int(parts[0][1:], 10), parts[1]
     except ValueError:
         return None
 
@@ -48,27 +299,472 @@ class McuSpec:
     name: str
     port: str
     baudrate: int = 250000
+    binary: bool = False  # switch to the framed binary protocol after connect
+    # hidraw node for press/release (firmware HOTKEY_HID=1), "auto" to find it next to port
+    hid: Optional[str] = None
+
+
+def find_hidraw(port: str) -> Optional[str]:
+    """/dev/hidrawN of the firmware's HID interface (HOTKEY_HID=1) on the same USB device as port."""
+    try:
+        tty = os.path.basename(os.path.realpath(port))
+        usb_dev = os.path.dirname(os.path.realpath(f"/sys/class/tty/{tty}/device"))  # interface -> device
+        for name in sorted(os.listdir("/sys/class/hidraw")):
+            hid_if = os.path.realpath(f"/sys/class/hidraw/{name}/device")
+            if hid_if.startswith(usb_dev + os.sep):
+                return f"/dev/{name}"
+    except OSError:
+        pass
+    return None
+
+
+# base colors a command sets: [(button_id, color)], ALL_BUTTONS for SET_ALL
+ALL_BUTTONS = -1
+LedUpdate = List[Tuple[int, str]]
+
+# queued command: ("line", text, leds) or ("frame", (op, args), leds); seq is assigned when it goes out.
+# ("mark", SyncFrame, None) sends nothing, it ticks the frame's countdown (see SyncFrame)
+TxItem = Tuple[str, Any, Optional[LedUpdate]]
+
+
+class SyncFrame:
+    """
+    One synchronized() block on its way to COMMIT: `waiting` counts the panels whose staged
+    commands are not all acknowledged yet. The SerialLoop commits once it reaches 0, or at
+    `deadline` with whatever landed by then.
+    """
+
+    def __init__(self, frame_id: int, conns: List["McuConnection"], deadline: float):
+        self.frame_id = frame_id
+        self.conns = conns
+        self.deadline = deadline
+        self.waiting = len(conns)
+
+
+class LedShadow:
+    """
+    Host copy of one MCU's base colors. `want` is what the application asked for, `shown` what
+    the firmware shows once everything queued so far has landed (None = unknown). Only changes
+    against `shown` go out; a rejected or lost command makes the buttons it touched unknown.
+    """
+
+    def __init__(self) -> None:
+        self.want_all: Optional[str] = None
+        self.want: Dict[int, str] = {}
+        self.shown_all: Optional[str] = None
+        self.shown: Dict[int, Optional[str]] = {}
+
+    def showing(self, bid: int) -> Optional[str]:
+        return self.shown[bid] if bid in self.shown else self.shown_all
+
+    def set_all(self, color: str) -> bool:
+        """Record SET_ALL; False if every button already shows it."""
+        self.want_all = color
+        self.want.clear()
+        if self.shown_all == color and all(c == color for c in self.shown.values()):
+            return False
+        self.shown_all = color
+        self.shown.clear()
+        return True
+
+    def set(self, bid: int, color: str) -> bool:
+        """Record one button; False if it already shows that color."""
+        self.want[bid] = color
+        if self.showing(bid) == color:
+            return False
+        self.shown[bid] = color
+        return True
+
+    def failed(self, leds: LedUpdate) -> None:
+        for bid, c in leds:
+            if bid == ALL_BUTTONS:
+                if self.shown_all == c:
+                    self.shown_all = None
+            elif self.shown.get(bid) == c:
+                self.shown[bid] = None
+
+    def forget(self) -> None:
+        self.shown_all = None
+        self.shown.clear()
+
+    def colors(self, buttons: int) -> Optional[List[str]]:
+        """Wanted color per button, None while nothing was ever set."""
+        if self.want_all is None and not self.want:
+            return None
+        return [self.want.get(bid, self.want_all or "000000") for bid in range(buttons)]
+
+    def assume_shown(self) -> None:
+        """The device already shows everything wanted."""
+        self.shown_all = self.want_all
+        self.shown = dict(self.want)
+
+    def resync(self) -> Tuple[Optional[str], LedUpdate]:
+        """Device state lost: everything wanted, as one SET_ALL color plus the buttons on top."""
+        want_all, want = self.want_all, dict(self.want)
+        self.forget()
+        if want_all is not None:
+            self.set_all(want_all)
+        return want_all, [(bid, c) for bid, c in want.items() if self.set(bid, c)]
+
+
+class SerialLoop:
+    """
+    One thread for any number of McuConnections: blocks in select() on every port plus a wake
+    pipe, reads as soon as bytes arrive (callbacks run right there) and writes while the port
+    is writable. Nothing polls; the only timeout is the earliest pending ack deadline.
+    """
+
+    def __init__(self, name: str = "mcu-loop"):
+        self._name = name
+        self._sel = selectors.DefaultSelector()
+        self._wake_r, self._wake_w = os.pipe()
+        os.set_blocking(self._wake_r, False)
+        os.set_blocking(self._wake_w, False)
+        self._sel.register(self._wake_r, selectors.EVENT_READ, None)
+
+        self._lock = threading.Lock()
+        self._woken = False
+        self._changes: List[Tuple[str, "McuConnection", Optional[threading.Event]]] = []
+        self._frames: List[SyncFrame] = []  # waiting to be committed, guarded by _lock
+        self._conns: Dict[int, "McuConnection"] = {}  # fd -> connection
+        self._hids: Dict[int, "McuConnection"] = {}  # hidraw fd -> connection, read only
+        self._events: Dict[int, int] = {}  # fd -> registered selector mask
+        self._thread: Optional[threading.Thread] = None
+        self._stop = False
+
+    def start(self) -> None:
+        if self._thread and self._thread.is_alive():
+            return
+        self._stop = False
+        self._thread = threading.Thread(target=self._run, name=self._name, daemon=True)
+        self._thread.start()
+
+    def stop(self) -> None:
+        self._stop = True
+        self.wake()
+        t = self._thread
+        if t and t.is_alive() and t is not threading.current_thread():
+            t.join(timeout=1.0)
+        self._thread = None
+
+    def wake(self) -> None:
+        with self._lock:
+            if self._woken:
+                return
+            self._woken = True
+        try:
+            os.write(self._wake_w, b"\0")
+        except BlockingIOError:
+            pass
+
+    def add(self, conn: "McuConnection") -> None:
+        self._change("add", conn, wait=False)
+
+    def commit_when_acked(self, frame_id: int, conns: List["McuConnection"], timeout: float) -> None:
+        """
+        COMMIT <frame_id> to every conn in one loop pass, once each one has everything queued
+        so far acknowledged, or after timeout. Returns right away; the commit runs on the loop thread.
+        """
+        frame = SyncFrame(frame_id, conns, time.monotonic() + timeout)
+        with self._lock:
+            self._frames.append(frame)
+        for conn in conns:
+            conn._mark(frame)
+        self.wake()
+
+    def _frame_acked(self, frame: SyncFrame) -> None:
+        """One panel's staged commands are all acknowledged (or lost); any thread."""
+        with self._lock:
+            frame.waiting -= 1
+            due = frame.waiting == 0
+        if due:
+            self.wake()
+
+    def _commit_frames(self) -> Optional[float]:
+        """Queue COMMIT for every frame that is due; returns the next frame deadline."""
+        now = time.monotonic()
+        with self._lock:
+            due = [f for f in self._frames if f.waiting <= 0 or f.deadline <= now]
+            self._frames = [f for f in self._frames if f.waiting > 0 and f.deadline > now]
+            deadline = min((f.deadline for f in self._frames), default=None)
+        for frame in due:
+            # staged commands not acked by now show with the next frame instead
+            for conn in frame.conns:
+                if conn.is_connected():
+                    conn.commit(frame.frame_id, kick=False)
+        return deadline
+
+    def remove(self, conn: "McuConnection") -> None:
+        """Returns once the loop no longer touches conn's port, so it can be closed."""
+        self._change("remove", conn, wait=True)
+
+    def _change(self, what: str, conn: "McuConnection", wait: bool) -> None:
+        if threading.current_thread() is self._thread:
+            self._apply(what, conn)
+            return
+        done = threading.Event() if wait and self._thread and self._thread.is_alive() else None
+        with self._lock:
+            self._changes.append((what, conn, done))
+        self.wake()
+        if done:
+            done.wait(timeout=1.0)
+
+    def _apply(self, what: str, conn: "McuConnection") -> None:
+        fd = conn._fileno()
+        if what == "add" and fd is not None and fd not in self._conns:
+            self._sel.register(fd, selectors.EVENT_READ, conn)
+            self._conns[fd] = conn
+            self._events[fd] = selectors.EVENT_READ
+            hid_fd = conn._hid_fd
+            if hid_fd is not None and hid_fd not in self._hids:
+                self._sel.register(hid_fd, selectors.EVENT_READ, conn)
+                self._hids[hid_fd] = conn
+        elif what == "remove":
+            for f, c in list(self._conns.items()):
+                if c is conn:
+                    self._sel.unregister(f)
+                    del self._conns[f]
+                    del self._events[f]
+            for f, c in list(self._hids.items()):
+                if c is conn:
+                    self._sel.unregister(f)
+                    del self._hids[f]
+
+    def _drain_changes(self) -> None:
+        with self._lock:
+            changes, self._changes = self._changes, []
+            self._woken = False
+        try:
+            while os.read(self._wake_r, 256):
+                pass
+        except BlockingIOError:
+            pass
+        for what, conn, done in changes:
+            try:
+                self._apply(what, conn)
+            finally:
+                if done:
+                    done.set()
+
+    def _drop(self, fd: int) -> None:
+        hid_conn = self._hids.pop(fd, None)
+        if hid_conn is not None:
+            self._sel.unregister(fd)
+            hid_conn._on_hid_error()  # CDC events take over again
+            return
+        conn = self._conns.get(fd)
+        if conn is not None:
+            self._apply("remove", conn)
+            conn._on_port_error()
+
+    def _run(self) -> None:
+        while not self._stop:
+            self._drain_changes()
+
+            # COMMITs that are due join this pass's writes, so every port gets its COMMIT together
+            deadline = self._commit_frames()
+
+            # queued commands go out first; interest in EVENT_WRITE only while bytes are left
+            for fd, conn in list(self._conns.items()):
+                try:
+                    want_write = conn._tx_ready()
+                except Exception:
+                    self._drop(fd)
+                    continue
+                mask = selectors.EVENT_READ | (selectors.EVENT_WRITE if want_write else 0)
+                if mask != self._events[fd]:
+                    self._sel.modify(fd, mask, conn)
+                    self._events[fd] = mask
+                due = conn._next_deadline()
+                if due is not None and (deadline is None or due < deadline):
+                    deadline = due
+
+            timeout = None if deadline is None else max(0.0, deadline - time.monotonic())
+            for key, mask in self._sel.select(timeout):
+                conn = key.data
+                if conn is None:
+                    continue  # wake pipe, drained at the top
+                try:
+                    if key.fd in self._hids:
+                        conn._hid_ready()
+                        continue
+                    if mask & selectors.EVENT_READ:
+                        conn._rx_ready()
+                    if mask & selectors.EVENT_WRITE:
+                        conn._tx_ready()
+                except Exception:
+                    self._drop(key.fd)
+
+        with self._lock:
+            self._changes.clear()
+            self._frames.clear()
 
 
 class McuConnection:
-    def __init__(self, spec: McuSpec, press_cb: Optional[PressCallback] = None):
+    def __init__(
+            self,
+            spec: McuSpec,
+            press_cb: Optional[PressCallback] = None,
+            max_in_flight: int = 8,
+            ack_timeout: float = 1.0,
+            event_cb: Optional[EventCallback] = None,
+            state_cb: Optional[StateCallback] = None,
+            loop: Optional[SerialLoop] = None,
+    ):
         self.spec = spec
+        self.verbose = True  # per-command log lines
         self._press_cb = press_cb
+        self._event_cb = event_cb
+        self._state_cb = state_cb
+        self._pong_cb: Optional[PongCallback] = None
+        self._ready_cb: Optional[Callable[[ReadyInfo], None]] = None
 
         self._ser = None
-        self._stop = threading.Event()
-        self._thread: Optional[threading.Thread] = None
+        self._hid_fd: Optional[int] = None  # open hidraw node, see McuSpec.hid
+        self._hid_mask = 0  # last bitmap from the HID report
+        self._loop = loop  # shared with other MCUs, or our own one created in connect()
+        self._own_loop = loop is None
 
-        self._txq: "queue.Queue[bytes]" = queue.Queue()
+        self._txq: "queue.Queue[TxItem]" = queue.Queue()
+        self._txbuf = bytearray()  # encoded, not yet accepted by the port
+        self._tx_lock = threading.Lock()  # guards _txbuf, _inflight and _seq
+        self._tx_idle = threading.Condition(self._tx_lock)  # notified when both run empty
         self._rxbuf = bytearray()
         self._lock = threading.Lock()
 
+        self._binary = False  # TX encoding for newly queued commands
+        self._binary_rx = False  # RX switches once the firmware acked PROTO BIN
+        self._proto_seq: Optional[int] = None
+        self._seq = 0
+
+        # commands sent but not yet acknowledged: seq -> (description, sent monotonic, leds)
+        self._inflight: Dict[int, Tuple[str, float, Optional[LedUpdate]]] = {}
+        self._max_in_flight = max(1, int(max_in_flight))
+        # synchronized() frames waiting for these seqs to be acknowledged, guarded by _tx_lock
+        self._marks: List[Tuple[Set[int], SyncFrame]] = []
+        self._ack_timeout = float(ack_timeout)
+
+        # color_single() calls waiting to be packed into SET_MANY (bid -> color)
+        self._pending_colors: Dict[int, str] = {}
+        self._pending_lock = threading.Lock()  # also guards _leds
+
+        # what the LEDs should show vs. what was sent; brightness is replayed on resync
+        self._leds = LedShadow()
+        self._want_brightness: Optional[int] = None
+        self._want_button_brightness: Dict[int, int] = {}
+        self._banner_seen = False
+        self._await_ready = False  # banner seen, the READY line should follow it
+        self.ready: Optional[ReadyInfo] = None  # from the last connect, None for older firmware
+
+        # firmware event log: last seq delivered in order, None until the first one
+        self._event_seq: Optional[int] = None
+        self._event_replay = False  # EVENTS SINCE sent, events past a gap wait for it
+        self._event_ack_due = False
+        self.events_lost = 0  # fell out of the firmware log before we got them
+        self.event_backlog_hwm = 0  # most unacknowledged events the firmware held this connection
+
+        # (buttons, crc) from the last SAVE_SCENE / LOAD_SCENE reply
+        self._scene_info: Optional[Tuple[int, int]] = None
+
     def _log(self, msg: str) -> None:
-        print(f"[mcu:{self.spec.name}] {msg}", flush=True)
+        if self.verbose:
+            print(f"[mcu:{self.spec.name}] {msg}", flush=True)
 
     def set_press_callback(self, cb: Optional[PressCallback]) -> None:
         self._press_cb = cb
 
+    def set_event_callback(self, cb: Optional[EventCallback]) -> None:
+        self._event_cb = cb
+
+    def set_state_callback(self, cb: Optional[StateCallback]) -> None:
+        self._state_cb = cb
+
+    def set_pong_callback(self, cb: Optional[PongCallback]) -> None:
+        self._pong_cb = cb
+
+    def set_ready_callback(self, cb: Optional[Callable[[ReadyInfo], None]]) -> None:
+        """Called on the loop thread for every READY, after the connection settled its own LED state."""
+        self._ready_cb = cb
+
+    def _on_pong(self, token: Optional[int], t_us: int) -> None:
+        if self._pong_cb:
+            try:
+                self._pong_cb(token, t_us)
+            except Exception:
+                pass
+
+    def _on_state(self, mask: int, t_us: Optional[int]) -> None:
+        if self._state_cb:
+            try:
+                self._state_cb(self.spec.name, mask, t_us)
+            except Exception:
+                pass
+
+    def _on_logged_event(self, kind: str, bid: int, t_us: Optional[int], seq: Optional[int], raw: str) -> None:
+        """Delivers firmware events strictly in seq order, a gap asks for a replay first."""
+        if seq is not None:
+            last = self._event_seq
+            if last is not None and seq <= last:
+                return  # seen already (replay overlapping the live stream)
+            if last is not None and seq != last + 1:
+                if not self._event_replay:
+                    self._log(f"events {last + 1}..{seq - 1} missing, asking for a replay")
+                    self._request_events(last)
+                return  # comes again with the replay
+            self._event_seq = seq
+            self._event_ack_due = True
+        self._on_event(kind, bid, t_us, raw)
+
+    def _on_event_info(self, nxt: int, last: int, lost: int, hwm: int) -> None:
+        self._event_replay = False
+        self.event_backlog_hwm = hwm
+        if self._event_seq is not None and last < self._event_seq:
+            # seq went backwards: the firmware rebooted, everything it logged is new to us
+            self._log("firmware event log restarted, replaying it")
+            self._event_seq = 0
+            self._request_events(0)
+            return
+        if lost:
+            self.events_lost += lost
+            self._log(f"{lost} events lost (firmware log overran), {self.events_lost} in total")
+        if self._event_seq is None or nxt - 1 > self._event_seq:
+            self._event_seq = nxt - 1
+
+    def _request_events(self, since: Optional[int]) -> None:
+        """EVENTS [SINCE=]: resume the stream after since; None only asks where it stands."""
+        self._event_replay = since is not None
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(OP_EVENTS, b"" if since is None else int(since).to_bytes(4, "little"))
+        elif since is None:
+            self.send_line("EVENTS")
+        else:
+            self.send_line(f"EVENTS SINCE={since}")
+
+    def _ack_events(self) -> None:
+        """One ACK per read batch instead of per event; frees the firmware's backlog count."""
+        if not self._event_ack_due or self._event_seq is None:
+            return
+        self._event_ack_due = False
+        if self._binary:
+            self._put_frame(OP_EVENT_ACK, int(self._event_seq).to_bytes(4, "little"))
+        else:
+            self._put_line(f"ACK S={self._event_seq}")
+
+    def _on_event(self, kind: str, bid: int, t_us: Optional[int], raw: str, hid: bool = False) -> None:
+        if self._hid_fd is not None and not hid and kind in ("pressed", "released"):
+            return  # the HID report already delivered it
+        if self._event_cb:
+            try:
+                self._event_cb(self.spec.name, kind, bid, t_us)
+            except Exception:
+                pass
+        if kind == "pressed" and self._press_cb:
+            try:
+                self._press_cb(self.spec.name, bid, raw)
+            except Exception:
+                pass
+
     def is_connected(self) -> bool:
         with self._lock:
             return self._ser is not None and getattr(self._ser, "is_open", False)
@@ -87,15 +783,34 @@ class McuConnection:
                 write_timeout=0,
             )
 
-        self._stop.clear()
-        self._thread = threading.Thread(target=self._worker, name=f"mcu-{self.spec.name}", daemon=True)
-        self._thread.start()
+        self._binary = False
+        self._binary_rx = False
+        self._proto_seq = None
+        with self._tx_lock:
+            self._inflight.clear()
+            settled = self._drop_marks_locked()
+        self._marks_settled(settled)
+        self._banner_seen = False
+        self._await_ready = False
+        self.ready = None
+        if self.spec.binary:
+            # everything queued after this is framed; RX follows once "#<seq> OK" arrives
+            self._put_line("PROTO BIN")
+            self._binary = True
+        # LEDs are replayed once READY says what the firmware shows (see _on_ready)
+        self._request_events(self._event_seq)  # whatever happened while the port was closed
+        self._open_hid()
+
+        if self._loop is None:
+            self._loop = SerialLoop(name=f"mcu-{self.spec.name}")
+        self._loop.add(self)
+        self._loop.start()
 
     def disconnect(self) -> None:
-        self._stop.set()
-        t = self._thread
-        if t and t.is_alive():
-            t.join(timeout=1.0)
+        if self._loop is not None:
+            self._loop.remove(self)
+            if self._own_loop:
+                self._loop.stop()
 
         with self._lock:
             if self._ser is not None:
@@ -104,69 +819,559 @@ class McuConnection:
                 except Exception:
                     pass
             self._ser = None
+        self._close_hid()
 
+        settled = []
         while not self._txq.empty():
             try:
-                self._txq.get_nowait()
+                item = self._txq.get_nowait()
             except Exception:
                 break
+            if item[0] == "mark":
+                settled.append(item[1])
+        with self._pending_lock:
+            self._pending_colors.clear()
+            self._leds.forget()
+        with self._tx_lock:
+            self._inflight.clear()
+            self._txbuf.clear()
+            settled += self._drop_marks_locked()
+            self._tx_idle.notify_all()
+        self._marks_settled(settled)
         self._rxbuf.clear()
 
+    def _want_hash(self, buttons: int) -> Optional[int]:
+        """scene_crc() of everything wanted, None while no color was ever set."""
+        with self._pending_lock:
+            colors = self._leds.colors(buttons)
+        if colors is None:
+            return None
+        levels = [self._want_button_brightness.get(bid, 255) for bid in range(buttons)]
+        brightness = FIRMWARE_BRIGHTNESS if self._want_brightness is None else self._want_brightness
+        return scene_crc(brightness, colors, levels)
+
+    def _on_ready(self, info: Optional[ReadyInfo]) -> None:
+        """Repaint after a (re)connect, unless the frame hash says the LEDs already are right."""
+        self._await_ready = False
+        self.ready = info
+        want = None if info is None else self._want_hash(info.buttons)
+        if info is not None and want == info.frame_hash:
+            with self._pending_lock:
+                self._pending_colors.clear()
+                self._leds.assume_shown()
+            self._log("READY, LEDs already match")
+        elif info is None or want is not None:
+            self._resync()
+        if info is not None and self._ready_cb:
+            try:
+                self._ready_cb(info)
+            except Exception:
+                pass
+
+    def _resync(self) -> None:
+        """Replay brightness and every wanted color; the firmware blanks them in onConnect()."""
+        if self._want_brightness is not None:
+            self.brightness(self._want_brightness)
+        for bid, level in list(self._want_button_brightness.items()):
+            self.brightness(level, bid)
+
+        with self._pending_lock:
+            self._pending_colors.clear()
+            want_all, items = self._leds.resync()
+            self._pending_colors.update(items)
+        if want_all is not None:
+            self._put_color_all(want_all)
+        self._flush_pending_colors()
+        if want_all is not None or items:
+            self._log(f"resync -> all={want_all} buttons={len(items)}")
+
     def send_line(self, line: str) -> None:
-        data = (line.strip() + "\n").encode("utf-8", errors="replace")
-        self._txq.put(data)
+        # keep ordering: queued single colors go out before anything sent after them
+        self._flush_pending_colors()
+        self._put_line(line)
+
+    def _put_line(self, line: str, leds: Optional[LedUpdate] = None) -> None:
+        self._txq.put(("line", line.strip(), leds))
+        self._kick()
+
+    def _put_frame(self, op: int, args: bytes = b"", leds: Optional[LedUpdate] = None) -> None:
+        self._txq.put(("frame", (op, bytes(args)), leds))
+        self._kick()
+
+    def _kick(self) -> None:
+        if self._loop is not None:
+            self._loop.wake()
+
+    def _mark(self, frame: SyncFrame) -> None:
+        """frame's countdown ticks for us once everything queued before this is acknowledged."""
+        self._flush_pending_colors()
+        self._txq.put(("mark", frame, None))
+
+    def _settle_locked(self, seq: int) -> List[SyncFrame]:
+        """seq got its reply (or never will): the frames whose last outstanding seq it was."""
+        settled = []
+        for pending, frame in self._marks:
+            pending.discard(seq)
+            if not pending:
+                settled.append(frame)
+        if settled:
+            self._marks = [mark for mark in self._marks if mark[0]]
+        return settled
+
+    def _drop_marks_locked(self) -> List[SyncFrame]:
+        settled, self._marks = [frame for _pending, frame in self._marks], []
+        return settled
+
+    def _marks_settled(self, frames: List[SyncFrame]) -> None:
+        if self._loop is not None:
+            for frame in frames:
+                self._loop._frame_acked(frame)
+
+    def in_flight(self) -> int:
+        with self._tx_lock:
+            return len(self._inflight)
+
+    def _idle_locked(self) -> bool:
+        # lock order: _tx_lock, then _pending_lock
+        with self._pending_lock:
+            pending = bool(self._pending_colors)
+        return not pending and self._txq.empty() and not self._txbuf and not self._inflight
+
+    def wait_idle(self, timeout: float = 5.0) -> bool:
+        """Block until everything queued so far went out and was acknowledged."""
+        with self._tx_idle:
+            return self._tx_idle.wait_for(self._idle_locked, timeout)
+
+    def ping(self, token: int) -> None:
+        """Answered with a pong (see set_pong_callback) right before the command's ack."""
+        token &= 0xFFFFFFFF
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(OP_PING, token.to_bytes(4, "little"))
+        else:
+            self.send_line(f"PING T={token}")
+
+    def trigger(self, ms: int = 50) -> None:
+        """Pulse the firmware's LOOPBACK_PIN low for ms; the pong callback gets (None, device time)."""
+        if ms < 1 or ms > 1000:
+            raise ValueError("ms must be 1..1000")
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(OP_TRIGGER, int(ms).to_bytes(2, "little"))
+        else:
+            self.send_line(f"TRIGGER MS={ms}")
+
+    def _scene_cmd(self, op: int, line: str, timeout: float) -> Optional[Tuple[int, int]]:
+        self._scene_info = None
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(op)
+        else:
+            self.send_line(line)
+        if not self.wait_idle(timeout):
+            return None
+        return self._scene_info
+
+    def stage(self, frame_id: int) -> None:
+        """LED changes after this stay off the LEDs until commit(frame_id) (or the firmware's STAGE_TIMEOUT_MS)."""
+        frame_id &= 0xFFFF
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(OP_STAGE, frame_id.to_bytes(2, "little"))
+        else:
+            self.send_line(f"STAGE ID={frame_id}")
+
+    def commit(self, frame_id: int, kick: bool = True) -> None:
+        """Show everything staged since stage(frame_id) in one frame. kick=False leaves the wake-up to the caller."""
+        frame_id &= 0xFFFF
+        self._flush_pending_colors()
+        if self._binary:
+            self._txq.put(("frame", (OP_COMMIT, frame_id.to_bytes(2, "little")), None))
+        else:
+            self._txq.put(("line", f"COMMIT ID={frame_id}", None))
+        if kick:
+            self._kick()
+
+    def load_scene(self, timeout: float = 2.0) -> Optional[Tuple[int, int]]:
+        """Show the scene saved on the device again; (buttons, crc) or None if there is none."""
+        return self._scene_cmd(OP_LOAD_SCENE, "LOAD_SCENE", timeout)
+
+    def save_scene(self, timeout: float = 2.0) -> Optional[Tuple[int, int]]:
+        """Make what the LEDs are set to now the device's power-on state; (buttons, crc) or None."""
+        info = self._scene_cmd(OP_SAVE_SCENE, "SAVE_SCENE", timeout)
+        if info is not None:
+            self._log(f"scene saved -> crc={info[1]:08x}")
+        return info
+
+    def clear_scene(self) -> None:
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(OP_CLEAR_SCENE)
+        else:
+            self.send_line("CLEAR_SCENE")
+
+    def assume_scene(
+            self,
+            color_all: Optional[str],
+            colors: LedUpdate,
+            brightness: Optional[int],
+            levels: List[Tuple[int, int]],
+    ) -> None:
+        """The device already shows this (a matching saved scene): record it without sending."""
+        with self._pending_lock:
+            self._leds.forget()
+            if color_all is not None:
+                self._leds.set_all(color_all)
+            for bid, c in colors:
+                self._leds.set(bid, c)
+        if brightness is not None:
+            self._want_brightness = brightness
+        for bid, level in levels:
+            self._want_button_brightness[bid] = level
+
+    def _encode_tx(self, item: TxItem, seq: int) -> Tuple[bytes, str]:
+        kind, val, _leds = item
+        if kind == "frame":
+            op, args = val
+            return encode_frame(bytes([op, seq]) + args), f"op=0x{op:02X}"
+        if val.upper() == "PROTO BIN":
+            self._proto_seq = seq
+        return f"#{seq} {val}\n".encode("utf-8", errors="replace"), val
+
+    def _pump_tx(self) -> None:
+        """Encode queued commands while fewer than max_in_flight are unacknowledged."""
+        now = time.monotonic()
+        expired = []
+        settled: List[SyncFrame] = []
+        with self._tx_lock:
+            for seq, entry in list(self._inflight.items()):
+                if now - entry[1] > self._ack_timeout:
+                    del self._inflight[seq]
+                    expired.append((seq, entry))
+                    settled += self._settle_locked(seq)
+
+            while len(self._inflight) < self._max_in_flight:
+                try:
+                    item = self._txq.get_nowait()
+                except queue.Empty:
+                    break
+                if item[0] == "mark":
+                    if self._inflight:
+                        self._marks.append((set(self._inflight), item[1]))
+                    else:
+                        settled.append(item[1])
+                    continue
+                self._seq = (self._seq + 1) & 0xFF
+                data, desc = self._encode_tx(item, self._seq)
+                self._txbuf.extend(data)
+                self._inflight[self._seq] = (desc, now, item[2])
+            if expired and not self._inflight and not self._txbuf:
+                self._tx_idle.notify_all()
+
+        self._marks_settled(settled)
+        for seq, (desc, _sent, leds) in expired:
+            self._log(f"no reply for #{seq} {desc}")
+            self._leds_failed(leds)
+
+    # --- SerialLoop side, always on the loop thread ---
+
+    def _fileno(self) -> Optional[int]:
+        with self._lock:
+            ser = self._ser
+        try:
+            return ser.fileno() if ser is not None else None
+        except Exception:
+            return None
+
+    def _next_deadline(self) -> Optional[float]:
+        with self._tx_lock:
+            if not self._inflight:
+                return None
+            return min(sent for _desc, sent, _leds in self._inflight.values()) + self._ack_timeout
+
+    def _tx_ready(self) -> bool:
+        """Write as much as the port takes; True while bytes are left over."""
+        self._flush_pending_colors()
+        self._pump_tx()
+        with self._tx_lock:
+            while self._txbuf:
+                n = self._ser.write(self._txbuf)  # non-blocking (write_timeout=0), may be partial
+                if not n:
+                    break
+                del self._txbuf[:n]
+            return bool(self._txbuf)
+
+    def _rx_ready(self) -> None:
+        n = self._ser.in_waiting
+        if not n:
+            raise OSError("port readable without data")  # hung up
+        self._rxbuf.extend(self._ser.read(n))
+        self._process_rx_lines()
+        self._ack_events()
+        self._tx_ready()  # acks just freed window slots
+
+    def _on_port_error(self) -> None:
+        self._log("serial port failed, closing")
+        with self._lock:
+            ser, self._ser = self._ser, None
+        if ser is not None:
+            try:
+                ser.close()
+            except Exception:
+                pass
+
+    def _open_hid(self) -> None:
+        path = self.spec.hid
+        if path == "auto":
+            path = find_hidraw(self.spec.port)
+        if not path:
+            if self.spec.hid:
+                self._log("no HID interface found, press events come over serial")
+            return
+        try:
+            self._hid_fd = os.open(path, os.O_RDONLY | os.O_NONBLOCK)
+        except OSError as e:
+            self._log(f"cannot open {path}: {e}, press events come over serial")
+            return
+        self._hid_mask = 0
+        self._log(f"HID reports from {path}")
+
+    def _close_hid(self) -> None:
+        fd, self._hid_fd = self._hid_fd, None
+        if fd is not None:
+            try:
+                os.close(fd)
+            except OSError:
+                pass
+
+    def _hid_ready(self) -> None:
+        """One read per input report: [report id] [pressed u32] [time us u32], id only with several HID devices."""
+        while True:
+            try:
+                report = os.read(self._hid_fd, 64)
+            except BlockingIOError:
+                return
+            if not report:
+                raise OSError("hidraw closed")
+            if len(report) == 9:
+                report = report[1:]
+            if len(report) != 8:
+                continue
+            mask = int.from_bytes(report[0:4], "little")
+            t_us = int.from_bytes(report[4:8], "little")
+            changed, self._hid_mask = mask ^ self._hid_mask, mask
+            bid = 0
+            while changed >> bid:
+                if (changed >> bid) & 1:
+                    kind = "pressed" if (mask >> bid) & 1 else "released"
+                    self._on_event(kind, bid, t_us, f"{kind} {bid} t={t_us}", hid=True)
+                bid += 1
+            self._on_state(mask, t_us)
+
+    def _on_hid_error(self) -> None:
+        self._log("HID interface failed, press events come over serial")
+        self._close_hid()
+
+    def _leds_failed(self, leds: Optional[LedUpdate]) -> None:
+        if leds:
+            with self._pending_lock:
+                self._leds.failed(leds)
+
+    def _on_reply(self, seq: int, status: str) -> None:
+        with self._tx_lock:
+            entry = self._inflight.pop(seq, None)
+            settled = self._settle_locked(seq) if entry else []
+            if not self._inflight and not self._txbuf:
+                self._tx_idle.notify_all()
+        self._marks_settled(settled)
+        if status != "OK":
+            desc = entry[0] if entry else "?"
+            self._log(f"#{seq} {desc} -> {status}")
+            if entry:
+                self._leds_failed(entry[2])
+        if seq == self._proto_seq:
+            self._proto_seq = None
+            self._binary_rx = status == "OK"
+
+    def _flush_pending_colors(self) -> None:
+        with self._pending_lock:
+            if not self._pending_colors:
+                return
+            items = list(self._pending_colors.items())
+            self._pending_colors.clear()
+
+        if self._binary:
+            per_frame = MAX_FRAME_ARGS // 4
+            for i in range(0, len(items), per_frame):
+                chunk = items[i: i + per_frame]
+                self._put_frame(OP_SET_MANY, b"".join(bytes([bid]) + _rgb(c) for bid, c in chunk), chunk)
+            return
+
+        if len(items) == 1:
+            bid, c = items[0]
+            self._put_line(f"SET_SINGLE B={bid} C={c}", items)
+            return
+
+        line, chunk = "SET_MANY", []
+        for bid, c in items:
+            entry = f" {bid}={c}"
+            if len(line) + len(entry) > MAX_LINE_LEN:
+                self._put_line(line, chunk)
+                line, chunk = "SET_MANY", []
+            line += entry
+            chunk.append((bid, c))
+        self._put_line(line, chunk)
+
+    def _put_color_all(self, c: str) -> None:
+        leds = [(ALL_BUTTONS, c)]
+        if self._binary:
+            self._put_frame(OP_SET_ALL, _rgb(c), leds)
+        else:
+            self._put_line(f"SET_ALL C={c}", leds)
 
-    def color_all(self, color: Color) -> None:
+    def color_all(self, color: Color) -> bool:
+        """Returns False if every button already showed that color (nothing sent)."""
         c = _norm_color(color)
-        self.send_line(f"SET_ALL C={c}")
+        with self._pending_lock:
+            self._pending_colors.clear()  # overwritten anyway
+            changed = self._leds.set_all(c)
+        if not changed:
+            return False
+        self._put_color_all(c)
         self._log(f"colorAll -> {c}")
+        return True
+
+    def flush(self) -> None:
+        """Show pending LED changes now instead of at the next firmware frame."""
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(OP_FLUSH)
+        else:
+            self.send_line("FLUSH")
 
-    def color_single(self, button_id: int, color: Color) -> None:
+    def color_single(self, button_id: int, color: Color) -> bool:
+        """Returns False if the button already showed that color (nothing queued)."""
         if button_id < 0 or button_id > 255:
             raise ValueError("button_id must be 0..255")
         c = _norm_color(color)
-        self.send_line(f"SET_SINGLE B={button_id} C={c}")
+        with self._pending_lock:
+            if not self._leds.set(button_id, c):
+                return False
+            self._pending_colors[button_id] = c
+        self._kick()
         self._log(f"colorSingle -> B={button_id} C={c}")
+        return True
 
-    def _worker(self) -> None:
-        idle_sleep = 0.005
-        while not self._stop.is_set():
-            with self._lock:
-                ser = self._ser
+    def differs(self, button_id: int, color: Color) -> bool:
+        """True if color_single(button_id, color) would send something."""
+        c = _norm_color(color)
+        with self._pending_lock:
+            return self._leds.showing(button_id) != c
 
-            if ser is None or not ser.is_open:
-                time.sleep(idle_sleep)
-                continue
+    def report(self, events: Optional[bool] = None, state: Optional[bool] = None) -> None:
+        """Choose what button changes produce: per-button events and/or one state bitmap."""
+        if events is None and state is None:
+            return
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(OP_REPORT, bytes([
+                0xFF if events is None else int(bool(events)),
+                0xFF if state is None else int(bool(state)),
+            ]))
+            return
 
-            # TX
-            try:
-                for _ in range(8):
-                    try:
-                        pkt = self._txq.get_nowait()
-                    except queue.Empty:
-                        break
-                    try:
-                        ser.write(pkt)
-                    except Exception:
-                        break
-            except Exception:
-                pass
+        args = []
+        if events is not None:
+            args.append(f"EVENTS={int(bool(events))}")
+        if state is not None:
+            args.append(f"STATE={int(bool(state))}")
+        self.send_line("REPORT " + " ".join(args))
 
-            # RX
-            try:
-                n = getattr(ser, "in_waiting", 0) or 0
-                if n:
-                    chunk = ser.read(n)
-                    if chunk:
-                        self._rxbuf.extend(chunk)
-                        self._process_rx_lines()
-                else:
-                    time.sleep(idle_sleep)
-            except Exception:
-                time.sleep(idle_sleep)
+    def brightness(self, level: int, button_id: Optional[int] = None) -> None:
+        """Global brightness, or one button's level on top of it. Shown with the next frame."""
+        if level < 0 or level > 255:
+            raise ValueError("brightness must be 0..255")
+        if button_id is not None and (button_id < 0 or button_id > 254):
+            raise ValueError("button_id must be 0..254")
+        if button_id is None:
+            self._want_brightness = level
+        else:
+            self._want_button_brightness[button_id] = level
+
+        if self._binary:
+            self._flush_pending_colors()
+            self._put_frame(OP_SET_BRIGHTNESS, bytes([0xFF if button_id is None else button_id, level]))
+        elif button_id is None:
+            self.send_line(f"SET_BRIGHTNESS V={level}")
+        else:
+            self.send_line(f"SET_BRIGHTNESS B={button_id} V={level}")
+        self._log(f"brightness -> {level}" + ("" if button_id is None else f" B={button_id}"))
+
+    def effect(
+            self,
+            button_id: int,
+            effect: str,
+            color: Color = "000000",
+            color2: Color = "000000",
+            period_ms: int = 1000,
+            duration_ms: int = 0,
+            phase_ms: int = 0,
+    ) -> None:
+        """
+        Run an on-device effect on top of the button's color. duration_ms=0 keeps it
+        until replaced; otherwise the firmware reverts to the base color by itself.
+        """
+        if button_id < 0 or button_id > 255:
+            raise ValueError("button_id must be 0..255")
+        name = str(effect).strip().lower()
+        if name not in EFFECTS:
+            raise ValueError(f"Unknown effect '{effect}', expected one of {list(EFFECTS)}")
+        for v in (period_ms, duration_ms, phase_ms):
+            if v < 0 or v > 0xFFFF:
+                raise ValueError("effect times must be 0..65535 ms")
+        if period_ms == 0:
+            raise ValueError("period_ms must be > 0")
+        c, c2 = _norm_color(color), _norm_color(color2)
+
+        if self._binary:
+            self._flush_pending_colors()
+            args = (
+                bytes([button_id, EFFECTS[name]]) + _rgb(c) + _rgb(c2)
+                + int(period_ms).to_bytes(2, "little")
+                + int(duration_ms).to_bytes(2, "little")
+                + int(phase_ms).to_bytes(2, "little")
+            )
+            self._put_frame(OP_SET_EFFECT, args)
+        else:
+            self.send_line(
+                f"SET_EFFECT B={button_id} E={name.upper()} C={c} C2={c2} "
+                f"P={int(period_ms)} T={int(duration_ms)} PH={int(phase_ms)}"
+            )
+        self._log(f"effect -> B={button_id} E={name} C={c} P={period_ms} T={duration_ms}")
+
+    def color_many(self, colors: Union[Dict[int, Color], List[Tuple[int, Color]]]) -> None:
+        """Set several buttons at once; sent as SET_MANY and shown in a single frame."""
+        items = colors.items() if isinstance(colors, dict) else colors
+        normed: List[Tuple[int, str]] = []
+        for button_id, color in items:
+            if button_id < 0 or button_id > 255:
+                raise ValueError("button_id must be 0..255")
+            normed.append((int(button_id), _norm_color(color)))
+
+        with self._pending_lock:
+            changed = [(bid, c) for bid, c in normed if self._leds.set(bid, c)]
+            self._pending_colors.update(changed)
+        if not changed:
+            return
+        self._flush_pending_colors()
+        self._log(f"colorMany -> {' '.join(f'{b}={c}' for b, c in changed)}")
 
     def _process_rx_lines(self) -> None:
         while True:
+            if self._binary_rx:
+                self._process_rx_frames()
+                return
+
             idx = self._rxbuf.find(b"\n")
             if idx < 0:
                 return
@@ -177,21 +1382,114 @@ class McuConnection:
             if line.endswith("\r"):
                 line = line[:-1]
 
-            bid = _parse_pressed_line(line)
-            if bid is not None and self._press_cb:
-                try:
-                    self._press_cb(self.spec.name, bid, line)
-                except Exception:
-                    pass
+            ready = _parse_ready_line(line)
+            if ready is not None:
+                self._on_ready(ready)
+                continue
+            if self._await_ready:
+                # READY follows the banner directly; anything else, even a reply to
+                # our own EVENTS, means firmware without it: replay everything
+                self._on_ready(None)
+
+            reply = _parse_reply_line(line)
+            if reply is not None:
+                self._on_reply(*reply)
+                continue
+
+            if line.startswith(FIRMWARE_BANNER):
+                # the first one belongs to our own connect(); any later one means the
+                # firmware saw the port reopen and reset the LEDs
+                if self._banner_seen:
+                    self._request_events(self._event_seq)
+                self._banner_seen = True
+                self._await_ready = True
+                continue
+
+            ev = _parse_event_line(line)
+            if ev is not None:
+                self._on_logged_event(*ev, line)
+                continue
+
+            info = _parse_events_line(line)
+            if info is not None:
+                self._on_event_info(*info)
+                continue
+
+            st = _parse_state_line(line)
+            if st is not None:
+                self._on_state(*st)
+                continue
+
+            pong = _parse_pong_line(line)
+            if pong is not None:
+                self._on_pong(*pong)
+                continue
+
+            scene = _parse_scene_line(line)
+            if scene is not None:
+                self._scene_info = scene
+
+    def _process_rx_frames(self) -> None:
+        while True:
+            idx = self._rxbuf.find(b"\x00")
+            if idx < 0:
+                return
+            raw = bytes(self._rxbuf[:idx])
+            del self._rxbuf[: idx + 1]
+            if not raw:
+                continue
+
+            payload = decode_frame(raw)
+            if payload is None:
+                continue  # garbage or text from before the switch
+
+            op = payload[0]
+            if op in EVENT_OPS and len(payload) in (2, 6, 10):
+                kind, bid = EVENT_OPS[op], payload[1]
+                t_us = int.from_bytes(payload[2:6], "little") if len(payload) >= 6 else None
+                seq = int.from_bytes(payload[6:10], "little") if len(payload) == 10 else None
+                self._on_logged_event(kind, bid, t_us, seq, f"{kind} {bid}" + ("" if t_us is None else f" t={t_us}"))
+            elif op == OP_EVENT_INFO and len(payload) == 15:
+                self._on_event_info(
+                    int.from_bytes(payload[1:5], "little"), int.from_bytes(payload[5:9], "little"),
+                    int.from_bytes(payload[9:13], "little"), int.from_bytes(payload[13:15], "little"),
+                )
+            elif op == OP_PONG and len(payload) == 9:
+                self._on_pong(int.from_bytes(payload[1:5], "little"), int.from_bytes(payload[5:9], "little"))
+            elif op == OP_TRIGGERED and len(payload) == 5:
+                self._on_pong(None, int.from_bytes(payload[1:5], "little"))
+            elif op == OP_STATE and len(payload) == 9:
+                self._on_state(int.from_bytes(payload[1:5], "little"), int.from_bytes(payload[5:9], "little"))
+            elif op == OP_SCENE_INFO and len(payload) == 6:
+                self._scene_info = (payload[1], int.from_bytes(payload[2:6], "little"))
+            elif op == OP_ACK and len(payload) == 3:
+                self._on_reply(payload[1], FRAME_STATUS.get(payload[2], "UNKNOWN"))
 
 
 class MultiMcuSerial:
-    def __init__(self, press_cb: Optional[PressCallback] = None, startup_delay: float = 0.6):
+    def __init__(
+            self,
+            press_cb: Optional[PressCallback] = None,
+            startup_delay: float = 1.0,  # no READY by then: push the startup colors anyway
+            event_cb: Optional[EventCallback] = None,
+    ):
         self._press_cb = press_cb
+        self._event_cb = event_cb
+        self._state_cb: Optional[StateCallback] = None
         self._mcus: Dict[str, McuConnection] = {}
+        self._loop = SerialLoop()  # one thread for all ports
 
         self._startup_all: Dict[str, str] = {}
         self._static_buttons: Dict[str, List[Tuple[int, str]]] = {}
+        self._startup_brightness: Dict[str, int] = {}
+        self._button_brightness: Dict[str, List[Tuple[int, int]]] = {}
+        self._saved_scene: Dict[str, bool] = {}
+        self._sync_lock = threading.Lock()  # held only to open and close a frame, never across a block
+        self._sync_depth = 0  # synchronized() blocks inside the open frame, any thread
+        self._sync_conns: List[McuConnection] = []  # staged for it, empty: nothing to line up
+        self._sync_timeout = 0.0
+        self._frame_id = 0
+        self._startup_timers: Dict[str, threading.Timer] = {}
         self._startup_delay = float(startup_delay)
 
     def set_press_callback(self, cb: Optional[PressCallback]) -> None:
@@ -199,17 +1497,33 @@ class MultiMcuSerial:
         for m in self._mcus.values():
             m.set_press_callback(cb)
 
+    def set_event_callback(self, cb: Optional[EventCallback]) -> None:
+        self._event_cb = cb
+        for m in self._mcus.values():
+            m.set_event_callback(cb)
+
     def configure_static_from_config(self, cfg) -> None:
         self._startup_all.clear()
         self._static_buttons.clear()
+        self._startup_brightness.clear()
+        self._button_brightness.clear()
+        self._saved_scene.clear()
 
         if hasattr(cfg, "mcus"):
             for mcu_name, mcu_cfg in cfg.mcus.items():
                 col = getattr(mcu_cfg, "color_all", None)
                 if col:
                     self._startup_all[mcu_name] = _norm_color(col)
+                level = getattr(mcu_cfg, "brightness", None)
+                if level is not None:
+                    self._startup_brightness[mcu_name] = int(level)
+                self._saved_scene[mcu_name] = bool(getattr(mcu_cfg, "saved_scene", False))
 
         for b in cfg.buttons.values():
+            level = getattr(b, "led_brightness", None)
+            if level is not None:
+                self._button_brightness.setdefault(getattr(b, "mcu"), []).append((int(getattr(b, "button_id")), int(level)))
+
             if str(getattr(b, "led_state", "")).lower() != "static":
                 continue
             col = getattr(b, "led_color", None)
@@ -219,45 +1533,164 @@ class MultiMcuSerial:
             bid = int(getattr(b, "button_id"))
             self._static_buttons.setdefault(mcu_name, []).append((bid, _norm_color(col)))
 
-    def _apply_startup_for_mcu(self, mcu_name: str) -> None:
+    def _on_mcu_ready(self, mcu_name: str, info: ReadyInfo) -> None:
+        # loop thread: the startup path waits for acks, so it runs on its own thread
+        timer = self._startup_timers.pop(mcu_name, None)
+        if timer is None:
+            return  # a later READY (port reopened): the connection replays its own state
+        timer.cancel()
+        threading.Thread(
+            target=self._apply_startup_for_mcu, args=(mcu_name, info), name=f"startup-{mcu_name}", daemon=True,
+        ).start()
+
+    def _on_startup_timeout(self, mcu_name: str) -> None:
+        if self._startup_timers.pop(mcu_name, None) is not None:
+            self._apply_startup_for_mcu(mcu_name)  # firmware without READY
+
+    def _apply_startup_for_mcu(self, mcu_name: str, ready: Optional[ReadyInfo] = None) -> None:
         conn = self._mcus.get(mcu_name)
         if not conn or not conn.is_connected():
             return
 
+        level = self._startup_brightness.get(mcu_name)
+        levels = self._button_brightness.get(mcu_name, [])
         base = self._startup_all.get(mcu_name)
+        statics = self._static_buttons.get(mcu_name, [])
+
+        use_scene = self._saved_scene.get(mcu_name, False)
+
+        # what the panel shows right now: READY's frame hash, or the saved scene on older firmware
+        shown: Optional[Tuple[int, int]] = None
+        if ready is not None:
+            shown = (ready.buttons, ready.frame_hash)
+        elif use_scene:
+            shown = conn.load_scene()
+        if shown is not None and shown[1] == self._startup_scene_crc(mcu_name, shown[0]):
+            # host restart with the panel still lit, or a saved scene matching the config
+            conn.assume_scene(base, statics, level, levels)
+            print(f"[mcu:{mcu_name}] LEDs already match the config, startup colors skipped", flush=True)
+            return
+
+        if shown is not None:
+            # something else is showing: put back the defaults the config leaves out, so the
+            # panel ends up exactly like _startup_scene_crc() expects next time
+            if level is None:
+                level = FIRMWARE_BRIGHTNESS
+            configured = {bid for bid, _level in levels}
+            levels = levels + [(bid, 255) for bid in range(shown[0]) if bid not in configured]
+
+        if level is not None:
+            conn.brightness(level)
+        for bid, level in levels:
+            conn.brightness(level, bid)
         if base:
             conn.color_all(base)
+        if statics:
+            conn.color_many(statics)
+
+        if use_scene:
+            conn.save_scene()
 
-        for bid, col in self._static_buttons.get(mcu_name, []):
-            conn.color_single(bid, col)
+    def _startup_scene_crc(self, mcu_name: str, buttons: int) -> int:
+        """scene_crc() of what _apply_startup_for_mcu() sends, on a device with `buttons` LEDs."""
+        colors = [self._startup_all.get(mcu_name) or "000000"] * buttons
+        for bid, c in self._static_buttons.get(mcu_name, []):
+            if bid < buttons:
+                colors[bid] = c
+        levels = [255] * buttons
+        for bid, level in self._button_brightness.get(mcu_name, []):
+            if bid < buttons:
+                levels[bid] = level
+        brightness = self._startup_brightness.get(mcu_name, FIRMWARE_BRIGHTNESS)
+        return scene_crc(brightness, colors, levels)
 
     def connect(self, specs: Dict[str, McuSpec]) -> None:
         for name, spec in specs.items():
             if name not in self._mcus:
-                self._mcus[name] = McuConnection(spec, press_cb=self._press_cb)
+                self._mcus[name] = McuConnection(
+                    spec, press_cb=self._press_cb, event_cb=self._event_cb, state_cb=self._state_cb,
+                    loop=self._loop,
+                )
+                self._mcus[name].set_ready_callback(lambda info, n=name: self._on_mcu_ready(n, info))
 
         for name, conn in self._mcus.items():
             if name in specs:
+                # startup colors go out on READY; the timer only covers firmware that never sends it
+                timer = threading.Timer(self._startup_delay, self._on_startup_timeout, args=(name,))
+                timer.daemon = True
+                self._startup_timers[name] = timer
                 conn.connect()
-                threading.Timer(self._startup_delay, self._apply_startup_for_mcu, args=(name,)).start()
+                timer.start()
 
     def disconnect(self, mcu: Optional[str] = None) -> None:
         if mcu is None:
             for c in self._mcus.values():
                 c.disconnect()
+            self._loop.stop()
             return
         if mcu in self._mcus:
             self._mcus[mcu].disconnect()
 
+    @contextmanager
+    def synchronized(self, timeout: float = 0.2) -> Iterator[None]:
+        """
+        LED changes made inside show on every panel at once: STAGE <id> goes to each connected
+        MCU, then, once everything staged has been acknowledged (or after timeout), the loop
+        thread sends COMMIT <id> to all ports in one pass. Leaving the block never waits for
+        that. Nests, also across threads: the firmware stages one frame at a time, so blocks
+        that overlap share it and the last one to leave commits. Other threads are never held
+        up by a block's body, only by the brief open/close.
+        """
+        with self._sync_lock:
+            if not self._sync_depth:
+                conns = [c for c in self._mcus.values() if c.is_connected()]
+                self._sync_conns = conns if len(conns) >= 2 else []  # fewer: nothing to line up
+                if self._sync_conns:
+                    self._frame_id = (self._frame_id + 1) & 0xFFFF
+                    self._sync_timeout = timeout
+                    for c in self._sync_conns:
+                        c.stage(self._frame_id)
+            self._sync_depth += 1
+        try:
+            yield
+        finally:
+            with self._sync_lock:
+                self._sync_depth -= 1
+                if not self._sync_depth and self._sync_conns:
+                    # staged colors must have landed, else they miss the commit and show a frame later
+                    self._loop.commit_when_acked(self._frame_id, self._sync_conns, self._sync_timeout)
+                    self._sync_conns = []
+
     def colorAll(self, color: Color, mcu: Optional[str] = None) -> None:
         if mcu is None:
-            for c in self._mcus.values():
-                c.color_all(color)
+            with self.synchronized():
+                for c in self._mcus.values():
+                    c.color_all(color)
         else:
             self._mcus[mcu].color_all(color)
 
-    def colorSingle(self, mcu: str, button_id: int, color: Color) -> None:
-        self._mcus[mcu].color_single(button_id, color)
+    def colorSingle(self, mcu: str, button_id: int, color: Color) -> bool:
+        return self._mcus[mcu].color_single(button_id, color)
+
+    def ledDiffers(self, mcu: str, button_id: int, color: Color) -> bool:
+        return self._mcus[mcu].differs(button_id, color)
+
+    def colorMany(self, mcu: str, colors: Union[Dict[int, Color], List[Tuple[int, Color]]]) -> None:
+        self._mcus[mcu].color_many(colors)
+
+    def set_state_callback(self, cb: Optional[StateCallback]) -> None:
+        self._state_cb = cb
+        for m in self._mcus.values():
+            m.set_state_callback(cb)
+
+    def report(self, mcu: str, events: Optional[bool] = None, state: Optional[bool] = None) -> None:
+        self._mcus[mcu].report(events, state)
+
+    def brightness(self, mcu: str, level: int, button_id: Optional[int] = None) -> None:
+        self._mcus[mcu].brightness(level, button_id)
+
+    def effect(self, mcu: str, button_id: int, effect: str, color: Color, **kwargs: Any) -> None:
+        self._mcus[mcu].effect(button_id, effect, color, **kwargs)
 
     def isConnected(self, mcu: str) -> bool:
         return self._mcus[mcu].is_connected()
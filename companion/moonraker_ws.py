@@ -13,6 +13,7 @@ import websocket  # websocket-client
 
 StatusUpdateCb = Callable[[Dict[str, Any], float], None]
 NotifyCb = Callable[[str, Any], None]  # (method, params)
+ReplyCb = Callable[[Any, Optional[Any]], None]  # (result, error) for call_async()
 
 
 @dataclass
@@ -37,6 +38,7 @@ class MoonrakerWS:
     - connect()/close()
     - call(method, params, timeout) -> result
     - notify(method, params) fire-and-forget
+    - call_async(method, params, cb, timeout) -> sent without waiting, cb gets the reply or a timeout
     - status callback: notify_status_update (diffs)
     - notify callback: any notify_* (klippy ready/shutdown/etc)
     """
@@ -53,7 +55,10 @@ class MoonrakerWS:
         self._connected = threading.Event()
 
         self._pending_lock = threading.Lock()
-        self._pending: Dict[int, Tuple[threading.Event, Dict[str, Any]]] = {}
+        # rid -> (done, reply box, cb, deadline); call() waits itself, so its deadline is None
+        self._pending: Dict[int, Tuple[threading.Event, Dict[str, Any], Optional[ReplyCb], Optional[float]]] = {}
+        self._expiry: Optional[threading.Timer] = None  # fires at the earliest call_async() deadline
+        self._expiry_due: Optional[float] = None
 
         self._status_cb: Optional[StatusUpdateCb] = None
         self._notify_cb: Optional[NotifyCb] = None
@@ -121,10 +126,13 @@ class MoonrakerWS:
         self._wsapp = None
 
         with self._pending_lock:
-            for _rid, (ev, box) in list(self._pending.items()):
-                box["error"] = {"code": -1, "message": "Moonraker disconnected"}
-                ev.set()
+            pending = list(self._pending.values())
             self._pending.clear()
+            self._arm_expiry_locked(None)
+        for ev, box, cb, _deadline in pending:
+            box["error"] = {"code": -1, "message": "Moonraker disconnected"}
+            ev.set()
+            self._reply(cb, box)
 
     def _send(self, msg: Dict[str, Any]) -> None:
         raw = json.dumps(msg)
@@ -143,7 +151,8 @@ class MoonrakerWS:
             msg["params"] = params
         self._send(msg)
 
-    def call(self, method: str, params: Optional[Dict[str, Any]] = None, timeout: float = 5.0) -> Any:
+    def _request(self, method: str, params: Optional[Dict[str, Any]], cb: Optional[ReplyCb],
+                 deadline: Optional[float] = None) -> Tuple[int, threading.Event, Dict[str, Any]]:
         if not self.is_connected:
             raise RuntimeError("Moonraker not connected")
 
@@ -156,9 +165,54 @@ class MoonrakerWS:
         box: Dict[str, Any] = {}
 
         with self._pending_lock:
-            self._pending[rid] = (ev, box)
+            self._pending[rid] = (ev, box, cb, deadline)
+            if deadline is not None and (self._expiry_due is None or deadline < self._expiry_due):
+                self._arm_expiry_locked(deadline)
 
         self._send(msg)
+        return rid, ev, box
+
+    def call_async(self, method: str, params: Optional[Dict[str, Any]] = None,
+                   cb: Optional[ReplyCb] = None, timeout: float = 10.0) -> None:
+        """
+        Send a request and return at once; cb(result, error) runs on the websocket thread, or
+        with a timeout error on a timer thread if no reply came within timeout seconds.
+        """
+        self._request(method, params, cb, time.monotonic() + timeout)
+
+    def _arm_expiry_locked(self, due: Optional[float]) -> None:
+        if self._expiry is not None:
+            self._expiry.cancel()
+        self._expiry = None
+        self._expiry_due = due
+        if due is not None:
+            self._expiry = threading.Timer(max(0.0, due - time.monotonic()), self._expire_pending)
+            self._expiry.daemon = True
+            self._expiry.start()
+
+    def _expire_pending(self) -> None:
+        """Fail every call_async() past its deadline, like call() does on its timeout."""
+        now = time.monotonic()
+        with self._pending_lock:
+            expired = [rid for rid, e in self._pending.items() if e[3] is not None and e[3] <= now]
+            entries = [self._pending.pop(rid) for rid in expired]
+            left = [e[3] for e in self._pending.values() if e[3] is not None]
+            self._arm_expiry_locked(min(left) if left else None)
+        for ev, box, cb, _deadline in entries:
+            box["error"] = {"code": -1, "message": "Moonraker call timeout"}
+            ev.set()
+            self._reply(cb, box)
+
+    @staticmethod
+    def _reply(cb: Optional[ReplyCb], box: Dict[str, Any]) -> None:
+        if cb:
+            try:
+                cb(box.get("result"), box.get("error"))
+            except Exception:
+                pass
+
+    def call(self, method: str, params: Optional[Dict[str, Any]] = None, timeout: float = 5.0) -> Any:
+        rid, ev, box = self._request(method, params, None)
 
         if not ev.wait(timeout):
             with self._pending_lock:
@@ -257,12 +311,13 @@ class MoonrakerWS:
                 entry = self._pending.pop(rid, None)
             if entry is None:
                 return
-            ev, box = entry
+            ev, box, cb, _deadline = entry
             if data.get("error") is not None:
                 box["error"] = data.get("error")
             else:
                 box["result"] = data.get("result")
             ev.set()
+            self._reply(cb, box)
             return
 
         # Notification
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Board description, taken from the [env:*] build_flags in platformio.ini:
+//   -DHOTKEY_BUTTON_PINS_MAP=2,3,4,...  button i -> GPIO
+//   -DLEDS_PER_BUTTON=2 -DLED_PIN=29
+// Everything derived from it (masks, LED ranges, contiguity) is computed here at compile time.
+
+#ifndef HOTKEY_BUTTON_PINS_MAP
+  #error "Define HOTKEY_BUTTON_PINS_MAP in platformio.ini, e.g. -DHOTKEY_BUTTON_PINS_MAP=2,3,4,..."
+#endif
+
+#ifndef LEDS_PER_BUTTON
+  #define LEDS_PER_BUTTON 2
+#endif
+
+#ifndef LED_PIN
+  #define LED_PIN 29
+#endif
+
+template <uint8_t LedPin, uint8_t LedsPerButton, uint8_t... Pins>
+struct BoardConfig {
+  static constexpr uint8_t buttons = sizeof...(Pins);
+  static constexpr uint8_t pins[] = { Pins... };
+
+  static constexpr uint8_t ledPin = LedPin;
+  static constexpr uint8_t ledsPerButton = LedsPerButton;
+  static constexpr uint16_t numLeds = (uint16_t)buttons * LedsPerButton;
+
+  static constexpr uint32_t buttonMask = (buttons >= 32) ? 0xFFFFFFFFu : ((1u << buttons) - 1u);
+  static constexpr uint32_t pinMask = (0u | ... | (1u << Pins));
+
+  // ascending run (2,3,4,...) -> one shift extracts all buttons
+  static constexpr bool contiguous() {
+    for (uint8_t i = 1; i < buttons; i++) {
+      if (pins[i] != pins[0] + i) return false;
+    }
+    return true;
+  }
+
+  static constexpr uint16_t firstLed(uint8_t button) { return (uint16_t)button * LedsPerButton; }
+
+  // one value for every LED of the button's block; true if any of them changed
+  template <typename Px>
+  static bool fillButton(Px* leds, uint8_t button, const Px& v) {
+    Px* out = leds + firstLed(button);
+    bool changed = false;
+    for (uint8_t i = 0; i < LedsPerButton; i++) {
+      changed |= out[i] != v;
+      out[i] = v;
+    }
+    return changed;
+  }
+
+  // GPIO levels (bit n = GPIO n, active low) -> pressed mask (bit i = button i)
+  static constexpr uint32_t pressedFromGpio(uint32_t levels) {
+    const uint32_t low = ~levels;
+    if constexpr (contiguous()) {
+      return (low >> pins[0]) & buttonMask;
+    } else {
+      return gather(low, std::make_index_sequence<buttons>{});
+    }
+  }
+
+  static_assert(buttons > 0 && buttons <= 32, "button bitmaps are 32 bits wide");
+  static_assert(((Pins < 32) && ...), "button pins must be GPIO 0..31");
+  static_assert(__builtin_popcount(pinMask) == buttons, "HOTKEY_BUTTON_PINS_MAP lists a pin twice");
+  static_assert(LedsPerButton > 0, "LEDS_PER_BUTTON must be at least 1");
+
+private:
+  template <size_t... I>
+  static constexpr uint32_t gather(uint32_t low, std::index_sequence<I...>) {
+    return (0u | ... | (((low >> Pins) & 1u) << I));
+  }
+};
+
+using Board = BoardConfig<LED_PIN, LEDS_PER_BUTTON, HOTKEY_BUTTON_PINS_MAP>;
+
+// optional cross-check, the count itself comes from the pin map
+#ifdef HOTKEY_BUTTONS
+static_assert(Board::buttons == HOTKEY_BUTTONS, "HOTKEY_BUTTON_PINS_MAP must list exactly HOTKEY_BUTTONS pins");
+#endif
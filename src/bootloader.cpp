@@ -3,60 +3,8 @@
 
 #include "usbserial.h"
 
-#ifndef BOOT_KEY_PIN
-  #define BOOT_KEY_PIN -1
-#endif
-
-#ifndef BOOT_KEY_ACTIVE_LOW
-  #define BOOT_KEY_ACTIVE_LOW 1
-#endif
-
-#ifndef BOOT_DBL_MS
-  #define BOOT_DBL_MS 400
-#endif
-
-static constexpr uint32_t DEBOUNCE_MS = 20;
 UsbSerial usbSerial;
 
-void Bootloader::init() {
-#if BOOT_KEY_PIN >= 0
-  pinMode(BOOT_KEY_PIN, INPUT_PULLUP);
-  lastRaw_ = lastStable_ =
-      (digitalRead(BOOT_KEY_PIN) == (BOOT_KEY_ACTIVE_LOW ? LOW : HIGH));
-  lastChangeMs_ = millis();
-#else
-  // No boot key configured. Nothing to init.
-#endif
-}
-
-void Bootloader::check() {
-#if BOOT_KEY_PIN >= 0
-  const uint32_t now = millis();
-  const bool raw =
-      (digitalRead(BOOT_KEY_PIN) == (BOOT_KEY_ACTIVE_LOW ? LOW : HIGH));
-
-  if (raw != lastRaw_) {
-    lastRaw_ = raw;
-    lastChangeMs_ = now;
-  }
-
-  // debounce to stable state
-  if ((now - lastChangeMs_) >= DEBOUNCE_MS && raw != lastStable_) {
-    lastStable_ = raw;
-
-    // detect press edge
-    if (lastStable_) {
-      if ((now - lastPressMs_) <= BOOT_DBL_MS) {
-        loadBootloader();
-      }
-      lastPressMs_ = now;
-    }
-  }
-#else
-  // No boot key configured: no periodic check.
-#endif
-}
-
 void Bootloader::loadBootloader() {
 #if defined(ARDUINO_ARCH_RP2040)
   // Reboot into ROM USB UF2 mode (BOOTSEL)
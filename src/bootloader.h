@@ -5,18 +5,12 @@
 #pragma once
 #include <Arduino.h>
 
+// Entered with BOOT_BOOTLOADER or the boot chord (see chords.h)
 class Bootloader {
 public:
-    void init();
-    void check();
     void loadBootloader();
 
 #if defined(ARDUINO_ARCH_STM32)
     static void jumpToAddress(uint32_t addr);
 #endif
-
-    bool lastRaw_ = false;
-    bool lastStable_ = false;
-    uint32_t lastChangeMs_ = 0;
-    uint32_t lastPressMs_ = 0;
 };
\ No newline at end of file
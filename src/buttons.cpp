@@ -0,0 +1,62 @@
+#include "buttons.h"
+
+#include "ring.h"
+
+#if defined(ARDUINO_ARCH_RP2040)
+  #include "hardware/gpio.h"
+  #include "hardware/timer.h"
+#endif
+
+static SpscRing<Buttons::Sample, BUTTON_RING_SIZE> edgeRing;
+static volatile uint32_t edgeOverruns = 0;
+
+void Buttons::init() {
+  for (uint8_t pin : Board::pins) {
+    pinMode(pin, INPUT_PULLUP);
+  }
+
+#if BUTTON_SCAN_IRQ
+  for (uint8_t pin : Board::pins) {
+    attachInterrupt(digitalPinToInterrupt(pin), onEdge_, CHANGE);
+  }
+#endif
+}
+
+uint32_t Buttons::readPressed() {
+#if defined(ARDUINO_ARCH_RP2040)
+  return Board::pressedFromGpio(gpio_get_all());
+#else
+  uint32_t pressed = 0;
+  for (uint8_t i = 0; i < Board::buttons; i++) {
+    if (digitalRead(Board::pins[i]) == LOW) pressed |= 1u << i;
+  }
+  return pressed;
+#endif
+}
+
+uint32_t Buttons::nowUs() {
+#if defined(ARDUINO_ARCH_RP2040)
+  return time_us_32();
+#else
+  return micros();
+#endif
+}
+
+void Buttons::onEdge_() {
+  // runs in IRQ context: snapshot everything, let loop() do the debounce
+  if (!edgeRing.push(Sample{readPressed(), nowUs()})) {
+    edgeOverruns = edgeOverruns + 1;
+  }
+}
+
+bool Buttons::pop(Sample& out) {
+  return edgeRing.pop(out);
+}
+
+bool Buttons::pending() const {
+  return !edgeRing.empty();
+}
+
+uint32_t Buttons::overruns() const {
+  return edgeOverruns;
+}
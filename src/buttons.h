@@ -0,0 +1,39 @@
+#pragma once
+#include <Arduino.h>
+
+#include "board.h"
+
+// 1 = capture a snapshot on every GPIO edge (IRQ), 0 = poll from loop() only
+#ifndef BUTTON_SCAN_IRQ
+  #if defined(ARDUINO_ARCH_RP2040)
+    #define BUTTON_SCAN_IRQ 1
+  #else
+    #define BUTTON_SCAN_IRQ 0
+  #endif
+#endif
+
+#ifndef BUTTON_RING_SIZE
+  #define BUTTON_RING_SIZE 32
+#endif
+
+class Buttons {
+public:
+  // One snapshot of all buttons: bit i set = button i pressed.
+  struct Sample {
+    uint32_t pressed;
+    uint32_t timeUs;
+  };
+
+  void init();
+
+  static uint32_t readPressed(); // all buttons in a single GPIO read, mapped by Board
+  static uint32_t nowUs();
+
+  bool pop(Sample& out);                  // drain edge snapshots captured by the IRQ
+  bool pending() const;
+
+  uint32_t overruns() const;
+
+private:
+  static void onEdge_();
+};
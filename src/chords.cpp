@@ -0,0 +1,62 @@
+#include "chords.h"
+
+uint32_t Chords::update(uint32_t pressed, uint32_t nowUs) {
+  const uint32_t newly = pressed & ~last_;
+  last_ = pressed;
+  const uint32_t tapped = pending_ & ~pressed;
+  pending_ &= pressed;
+  swallowed_ &= pressed;
+
+  int8_t match = -1;
+  bool partial = false; // pressed could still grow into a chord
+  for (uint8_t i = 0; i < CHORD_COUNT; i++) {
+    const uint32_t mask = CHORDS[i].mask;
+    if (mask == 0) continue;
+    if (mask == pressed) {
+      match = (int8_t)i;
+      break;
+    }
+    if (!(pressed & ~mask)) partial = true;
+  }
+
+  if (match >= 0) {
+    swallowed_ |= (pending_ | newly) & CHORDS[match].mask; // what the host has seen stays
+    pending_ = 0;
+  } else if (!partial) {
+    pending_ = 0; // another button joined, no chord: show what was held back
+  } else if (newly) {
+    pending_ |= newly;
+    pendingUs_ = nowUs;
+  }
+
+  if (match != armed_) { // not still the same chord (or none)
+    armed_ = match;
+    fired_ = false;
+    sinceUs_ = nowUs;
+  }
+  return tapped;
+}
+
+void Chords::poll(uint32_t nowUs, Fire fire) {
+  if (pending_ && nowUs - pendingUs_ >= WINDOW_US) pending_ = 0;
+
+  uint32_t dueUs;
+  if (!holdDue_(dueUs) || (int32_t)(nowUs - dueUs) < 0) return;
+
+  fired_ = true; // once per hold, release to re-arm
+  fire((uint8_t)armed_, CHORDS[armed_], dueUs);
+}
+
+bool Chords::holdDue_(uint32_t& dueUs) const {
+  if (armed_ < 0 || fired_) return false;
+  dueUs = sinceUs_ + (uint32_t)CHORDS[armed_].holdMs * 1000u;
+  return true;
+}
+
+bool Chords::nextDue(uint32_t& dueUs) const {
+  const bool hold = holdDue_(dueUs);
+  if (!pending_) return hold;
+  const uint32_t windowUs = pendingUs_ + WINDOW_US;
+  if (!hold || (int32_t)(windowUs - dueUs) < 0) dueUs = windowUs;
+  return true;
+}
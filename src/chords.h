@@ -0,0 +1,86 @@
+#pragma once
+#include <Arduino.h>
+
+#include "board.h"
+
+// Device-side chords: a set of buttons held together (and nothing else) for holdMs.
+// Matching works on the whole debounced bitmap at once, so press order doesn't matter.
+// A chord's buttons never reach the host as presses (see Chords::visible()).
+
+// Buttons held for BOOT_CHORD_MS -> reboot to the UF2 bootloader, e.g.
+// -DBOOT_CHORD_MASK="((1u << 0) | (1u << (Board::buttons - 1)))" for first + last.
+// 0 = disabled: a stray hold would drop the panel off the bus, mid-print too.
+#ifndef BOOT_CHORD_MASK
+  #define BOOT_CHORD_MASK 0
+#endif
+
+#ifndef BOOT_CHORD_MS
+  #define BOOT_CHORD_MS 2000
+#endif
+
+// how long a chord button's press waits for the rest of its chord before the host gets it
+#ifndef CHORD_WINDOW_MS
+  #define CHORD_WINDOW_MS 150
+#endif
+
+enum class ChordAction : uint8_t { Report, Bootloader };
+
+struct Chord {
+  uint32_t mask;
+  uint16_t holdMs;
+  ChordAction action;
+};
+
+inline constexpr Chord CHORDS[] = {
+  { BOOT_CHORD_MASK, BOOT_CHORD_MS, ChordAction::Bootloader },
+};
+
+inline constexpr uint8_t CHORD_COUNT = sizeof(CHORDS) / sizeof(CHORDS[0]);
+
+constexpr bool chordsValid() {
+  for (const Chord& c : CHORDS) {
+    if (c.mask & ~Board::buttonMask) return false;
+  }
+  return true;
+}
+static_assert(chordsValid(), "chord masks must only name existing buttons");
+
+constexpr bool chordsDistinct() {
+  for (const Chord& c : CHORDS) {
+    if (c.mask && !(c.mask & (c.mask - 1))) return false; // a single button is just a long press
+  }
+  return true;
+}
+static_assert(chordsDistinct(), "a chord needs at least two distinct buttons");
+
+class Chords {
+public:
+  using Fire = void (*)(uint8_t index, const Chord& chord, uint32_t timeUs);
+
+  // pressed = full debounced bitmap after a change, nowUs = time of that sample. Returns the
+  // held-back buttons released before their window ended: show them pressed once, then released.
+  uint32_t update(uint32_t pressed, uint32_t nowUs);
+
+  // fires an armed chord once its hold time has passed, shows presses whose window ended
+  void poll(uint32_t nowUs, Fire fire);
+
+  bool nextDue(uint32_t& dueUs) const; // hold deadline of the armed chord, or end of the window
+
+  // what the host sees of pressed: a press that could start a chord waits CHORD_WINDOW_MS for
+  // the rest of it, and the buttons of a completed chord stay hidden until released
+  uint32_t visible(uint32_t pressed) const { return pressed & ~(pending_ | swallowed_); }
+
+private:
+  static constexpr uint32_t WINDOW_US = (uint32_t)CHORD_WINDOW_MS * 1000u;
+
+  bool holdDue_(uint32_t& dueUs) const;
+
+  int8_t armed_ = -1; // index into CHORDS
+  bool fired_ = false;
+  uint32_t sinceUs_ = 0;
+
+  uint32_t last_ = 0;      // pressed at the previous update
+  uint32_t pending_ = 0;   // presses waiting for the rest of a chord
+  uint32_t pendingUs_ = 0; // latest of them
+  uint32_t swallowed_ = 0; // buttons of a completed chord, still down
+};
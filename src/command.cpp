@@ -0,0 +1,89 @@
+#include "command.h"
+
+#include <cstdlib>
+
+static bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+bool Cmd::lex(char* line, CmdLine& out) {
+  out.count = 0;
+  char* p = line;
+
+  while (isSpace(*p)) p++;
+  if (!*p) return false;
+
+  out.name = p;
+  while (*p && !isSpace(*p)) p++;
+  out.nameLen = (uint8_t)(p - out.name);
+
+  while (*p) {
+    *p++ = '\0';
+    while (isSpace(*p)) p++;
+    if (!*p) break;
+
+    if (out.count >= CmdLine::MAX_TOKENS) return false;
+    CmdToken& t = out.tok[out.count++];
+    t.key = p;
+    t.val = nullptr;
+
+    while (*p && !isSpace(*p)) {
+      if (*p == '=' && !t.val) {
+        *p = '\0';
+        t.val = p + 1;
+      }
+      p++;
+    }
+  }
+  return true;
+}
+
+CmdResult Cmd::run(const Command& command, const CmdLine& line) {
+  CmdArgs args;
+
+  if (!command.freeForm) {
+    for (uint8_t t = 0; t < line.count; t++) {
+      const CmdToken& tok = line.tok[t];
+      if (!tok.val) return CmdResult::Err;
+
+      const size_t keyLen = (size_t)(tok.val - 1 - tok.key);
+      uint8_t i = 0;
+      while (i < command.argCount && !sameName(command.args[i].key, tok.key, keyLen)) i++;
+      if (i == command.argCount) return CmdResult::Err; // unknown key
+
+      const CmdArgSpec& spec = command.args[i];
+      if (spec.parse && !spec.parse(tok.val, &args.value[i])) return CmdResult::Err;
+      args.text[i] = tok.val;
+      args.seen |= (uint8_t)(1u << i);
+    }
+
+    for (uint8_t i = 0; i < command.argCount; i++) {
+      if (command.args[i].required && !args.has(i)) return CmdResult::Err;
+    }
+  }
+
+  return command.handler(args, line);
+}
+
+bool Cmd::parseDec(const char* s, uint32_t max, uint32_t* out) {
+  if (!s || *s < '0' || *s > '9') return false;
+  // by hand: strtoul() clamps an overflow to ULONG_MAX, which passes max for U32 fields
+  uint32_t v = 0;
+  for (; *s; s++) {
+    if (*s < '0' || *s > '9') return false;
+    const uint32_t d = (uint32_t)(*s - '0');
+    if (v > (max - d) / 10) return false;
+    v = v * 10 + d;
+  }
+  *out = v;
+  return true;
+}
+
+bool Cmd::parseColor24(const char* s, uint32_t* out) {
+  if (!s || !*s) return false;
+  if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) s += 2;
+
+  char* end = nullptr;
+  unsigned long v = strtoul(s, &end, 16);
+  if (!end || *end != '\0') return false;
+  *out = (uint32_t)v & 0x00FFFFFFu;
+  return true;
+}
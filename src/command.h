@@ -0,0 +1,155 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Text commands: "NAME [KEY=VALUE | WORD] ..."
+//
+// A line is split in place in one pass (separators and '=' become '\0'), the name is looked
+// up in a perfect hash table built at compile time, and the arguments are checked against the
+// command's declared schema before its handler runs.
+
+enum class CmdResult : uint8_t { Unknown, Ok, Err };
+
+struct CmdToken {
+  const char* key; // text before '=', or the whole word
+  const char* val; // text after '=', nullptr for a bare word
+};
+
+struct CmdLine {
+  static constexpr uint8_t MAX_TOKENS = 32;
+
+  const char* name = nullptr;
+  uint8_t nameLen = 0;
+  CmdToken tok[MAX_TOKENS];
+  uint8_t count = 0;
+};
+
+// One declared KEY=VALUE argument. parse == nullptr keeps only the text.
+struct CmdArgSpec {
+  const char* key;
+  bool (*parse)(const char* s, uint32_t* out);
+  bool required;
+};
+
+// Parsed arguments, indexed like the command's schema
+struct CmdArgs {
+  static constexpr uint8_t MAX_ARGS = 8;
+
+  uint32_t value[MAX_ARGS] = {};
+  const char* text[MAX_ARGS] = {};
+  uint8_t seen = 0; // bit i = argument i was given
+
+  bool has(uint8_t i) const { return seen & (1u << i); }
+  uint32_t get(uint8_t i, uint32_t fallback) const { return has(i) ? value[i] : fallback; }
+};
+
+using CmdHandler = CmdResult (*)(const CmdArgs& args, const CmdLine& line);
+
+struct Command {
+  const char* name;
+  CmdHandler handler;
+  const CmdArgSpec* args;
+  uint8_t argCount;
+  bool freeForm; // no schema, the handler reads line.tok itself
+};
+
+class Cmd {
+public:
+  static constexpr char lower(char c) { return (c >= 'A' && c <= 'Z') ? (char)(c + ('a' - 'A')) : c; }
+
+  static constexpr size_t length(const char* s) {
+    size_t n = 0;
+    while (s[n]) n++;
+    return n;
+  }
+
+  // case-insensitive FNV-1a
+  static constexpr uint32_t hash(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ (uint8_t)lower(s[i])) * 16777619u;
+    return h;
+  }
+
+  // a is NUL-terminated, b has length bLen
+  static constexpr bool sameName(const char* a, const char* b, size_t bLen) {
+    for (size_t i = 0; i < bLen; i++) {
+      if (!a[i] || lower(a[i]) != lower(b[i])) return false;
+    }
+    return a[bLen] == '\0';
+  }
+
+  template <size_t N>
+  static constexpr Command declare(const char* name, CmdHandler handler, const CmdArgSpec (&args)[N]) {
+    static_assert(N <= CmdArgs::MAX_ARGS, "too many arguments for one command");
+    return Command{ name, handler, args, (uint8_t)N, false };
+  }
+  static constexpr Command declare(const char* name, CmdHandler handler) {
+    return Command{ name, handler, nullptr, 0, false };
+  }
+  static constexpr Command declareFreeForm(const char* name, CmdHandler handler) {
+    return Command{ name, handler, nullptr, 0, true };
+  }
+
+  // value parsers for CmdArgSpec: whole string, no sign, range checked
+  static bool parseDec(const char* s, uint32_t max, uint32_t* out);
+  static bool parseBool(const char* s, uint32_t* out) { return parseDec(s, 1, out); }
+  static bool parseU8Dec(const char* s, uint32_t* out) { return parseDec(s, 255, out); }
+  static bool parseU16Dec(const char* s, uint32_t* out) { return parseDec(s, 65535, out); }
+  static bool parseU32Dec(const char* s, uint32_t* out) { return parseDec(s, 0xFFFFFFFFu, out); }
+  static bool parseColor24(const char* s, uint32_t* out); // RRGGBB, optional 0x
+
+  // false for an empty line or too many tokens
+  static bool lex(char* line, CmdLine& out);
+
+  // check the tokens against the schema, then call the handler
+  static CmdResult run(const Command& command, const CmdLine& line);
+};
+
+// Name -> command with one hash and one compare. The slot is the top bits of hash * multiplier;
+// the multiplier is searched at compile time until every name lands in its own slot, check
+// perfect() with a static_assert.
+template <size_t N, size_t Slots>
+class CommandTable {
+  static_assert((Slots & (Slots - 1)) == 0 && Slots >= N && Slots <= 256,
+                "Slots must be a power of two >= N");
+
+  static constexpr uint8_t log2(size_t v) { return v > 1 ? 1 + log2(v / 2) : 0; }
+  static constexpr uint8_t SHIFT = 32 - log2(Slots);
+
+public:
+  constexpr explicit CommandTable(const Command (&commands)[N]) : commands_(commands) {
+    for (uint32_t seed = 0; seed < 1024 && !perfect_; seed++) {
+      perfect_ = tryBuild(seed);
+    }
+  }
+
+  constexpr bool perfect() const { return perfect_; }
+
+  const Command* find(const char* name, size_t len) const {
+    const uint8_t i = slot_[slotOf(Cmd::hash(name, len), seed_)];
+    if (i == 0 || !Cmd::sameName(commands_[i - 1].name, name, len)) return nullptr;
+    return &commands_[i - 1];
+  }
+
+private:
+  static constexpr size_t slotOf(uint32_t h, uint32_t seed) {
+    return Slots == 1 ? 0 : (uint32_t)(h * (seed * 2u + 1u)) >> SHIFT;
+  }
+
+  constexpr bool tryBuild(uint32_t seed) {
+    for (size_t s = 0; s < Slots; s++) slot_[s] = 0;
+    for (size_t c = 0; c < N; c++) {
+      const char* name = commands_[c].name;
+      const size_t s = slotOf(Cmd::hash(name, Cmd::length(name)), seed);
+      if (slot_[s] != 0) return false;
+      slot_[s] = (uint8_t)(c + 1);
+    }
+    seed_ = seed;
+    return true;
+  }
+
+  const Command* commands_;
+  uint32_t seed_ = 0;
+  uint8_t slot_[Slots] = {}; // command index + 1, 0 = empty
+  bool perfect_ = false;
+};
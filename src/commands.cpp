@@ -0,0 +1,593 @@
+#include "commands.h"
+
+#include <cstring>
+#include <strings.h>
+
+#include "board.h"
+#include "device.h"
+#include "events.h"
+#include "frame.h"
+#include "led.h"
+#include "scene.h"
+
+// REPORT: per-button events and/or one bitmap per debounced change
+static bool reportEvents = true;
+static bool reportState = false;
+
+// STAGE ID=<id>: LED changes wait for COMMIT ID=<id>
+static bool staged = false;
+static uint16_t stagedId = 0;
+
+// copy of the scene in flash, shown at boot and on every connect
+static Scene savedScene;
+static bool haveScene = false;
+
+static bool parseEffect(const char* s, uint32_t* out) {
+  static const struct { const char* name; LedEffect fx; } names[] = {
+    { "NONE", LedEffect::None },   { "SOLID", LedEffect::Solid },
+    { "BLINK", LedEffect::Blink }, { "PULSE", LedEffect::Pulse },
+    { "BREATHE", LedEffect::Breathe }, { "CHASE", LedEffect::Chase },
+  };
+  for (const auto& n : names) {
+    if (strcasecmp(s, n.name) == 0) { *out = (uint32_t)n.fx; return true; }
+  }
+  return false;
+}
+
+// set by "PROTO BIN", applied after the text OK went out
+static bool switchToFramed = false;
+
+// --- command handlers; arguments are declared in COMMANDS below and arrive parsed ---
+
+static CmdResult cmdBootloader(const CmdArgs&, const CmdLine&)
+{
+  Device::rebootToBootloader();
+  return CmdResult::Ok; // (won't return on RP2040, but fine)
+}
+
+static CmdResult cmdConfig(const CmdArgs&, const CmdLine&)
+{
+  Device::printConfig();
+  return CmdResult::Ok;
+}
+
+// SET_SINGLE B=<id> C=<hex>
+static constexpr CmdArgSpec SET_SINGLE_ARGS[] = { { "B", Cmd::parseU8Dec, true }, { "C", Cmd::parseColor24, true } };
+
+static CmdResult cmdSetSingle(const CmdArgs& a, const CmdLine&)
+{
+  Led::setLed((uint8_t)a.value[0], a.value[1]); // button index -> lights its LED block
+  return CmdResult::Ok;
+}
+
+// SET_MANY <id>=<hex> [<id>=<hex> ...]
+static CmdResult cmdSetMany(const CmdArgs&, const CmdLine& line)
+{
+  uint8_t ids[Board::buttons];
+  uint32_t colors[Board::buttons];
+  if (line.count == 0 || line.count > Board::buttons) return CmdResult::Err;
+
+  // validate everything first so a bad entry leaves the frame untouched
+  for (uint8_t i = 0; i < line.count; i++) {
+    uint32_t id;
+    if (!line.tok[i].val || !Cmd::parseU8Dec(line.tok[i].key, &id)) return CmdResult::Err;
+    if (!Cmd::parseColor24(line.tok[i].val, &colors[i])) return CmdResult::Err;
+    ids[i] = (uint8_t)id;
+  }
+
+  Led::setLeds(ids, colors, line.count);
+  return CmdResult::Ok;
+}
+
+// SET_FRAME C=<hex6><hex6>... (buttons 0..n-1)
+static constexpr CmdArgSpec SET_FRAME_ARGS[] = { { "C", nullptr, true } };
+
+static CmdResult cmdSetFrame(const CmdArgs& a, const CmdLine&)
+{
+  const char* hexes = a.text[0];
+  const size_t len = strlen(hexes);
+  if (len == 0 || len % 6 != 0 || len / 6 > Board::buttons) return CmdResult::Err;
+
+  uint32_t colors[Board::buttons];
+  const uint8_t n = (uint8_t)(len / 6);
+  for (uint8_t i = 0; i < n; i++) {
+    char hex[7];
+    memcpy(hex, hexes + i * 6, 6);
+    hex[6] = '\0';
+    if (!Cmd::parseColor24(hex, &colors[i])) return CmdResult::Err;
+  }
+
+  Led::setLeds(nullptr, colors, n);
+  return CmdResult::Ok;
+}
+
+// SET_EFFECT B=<id> E=<NONE|SOLID|BLINK|PULSE|BREATHE|CHASE> [C=<hex>] [C2=<hex>]
+//            [P=<period ms>] [T=<duration ms>] [PH=<phase ms>]
+static constexpr CmdArgSpec SET_EFFECT_ARGS[] = {
+  { "B", Cmd::parseU8Dec, true },    { "E", parseEffect, true },
+  { "C", Cmd::parseColor24, false }, { "C2", Cmd::parseColor24, false },
+  { "P", Cmd::parseU16Dec, false },  { "T", Cmd::parseU16Dec, false },
+  { "PH", Cmd::parseU16Dec, false },
+};
+
+static CmdResult cmdSetEffect(const CmdArgs& a, const CmdLine&)
+{
+  LedEffectSpec fx;
+  fx.mode = (LedEffect)a.value[1];
+  fx.color = a.get(2, fx.color);
+  fx.color2 = a.get(3, fx.color2);
+  fx.periodMs = (uint16_t)a.get(4, fx.periodMs);
+  fx.durationMs = (uint16_t)a.get(5, fx.durationMs);
+  fx.phaseMs = (uint16_t)a.get(6, fx.phaseMs);
+  if (fx.periodMs == 0) return CmdResult::Err;
+
+  Led::setEffect((uint8_t)a.value[0], fx);
+  return CmdResult::Ok;
+}
+
+// PROTO BIN|TEXT: switch to the binary framed protocol (see frame.h)
+static CmdResult cmdProto(const CmdArgs&, const CmdLine& line)
+{
+  if (line.count != 1 || line.tok[0].val) return CmdResult::Err;
+  const char* mode = line.tok[0].key;
+  if (strcasecmp(mode, "TEXT") == 0) return CmdResult::Ok; // already text
+  if (strcasecmp(mode, "BIN") != 0) return CmdResult::Err;
+  switchToFramed = true;
+  return CmdResult::Ok;
+}
+
+// FLUSH: push pending LED changes now instead of at the next frame
+static CmdResult cmdFlush(const CmdArgs&, const CmdLine&)
+{
+  Led::flush();
+  return CmdResult::Ok;
+}
+
+// SET_BRIGHTNESS V=<0-255> [B=<id>]: global, or one button on top of it
+static constexpr CmdArgSpec SET_BRIGHTNESS_ARGS[] = { { "V", Cmd::parseU8Dec, true }, { "B", Cmd::parseU8Dec, false } };
+
+static CmdResult cmdSetBrightness(const CmdArgs& a, const CmdLine&)
+{
+  const uint8_t level = (uint8_t)a.value[0];
+  if (!a.has(1)) {
+    Led::setBrightness(level);
+    return CmdResult::Ok;
+  }
+  if (a.value[1] >= Board::buttons) return CmdResult::Err;
+  Led::setButtonBrightness((uint8_t)a.value[1], level);
+  return CmdResult::Ok;
+}
+
+// SET_ALL C=<hex>
+static constexpr CmdArgSpec SET_ALL_ARGS[] = { { "C", Cmd::parseColor24, true } };
+
+static CmdResult cmdSetAll(const CmdArgs& a, const CmdLine&)
+{
+  Led::setAllLed(a.value[0]);
+  return CmdResult::Ok;
+}
+
+// REPORT [EVENTS=0|1] [STATE=0|1]: what button changes produce
+static constexpr CmdArgSpec REPORT_ARGS[] = { { "EVENTS", Cmd::parseBool, false }, { "STATE", Cmd::parseBool, false } };
+
+static CmdResult cmdReport(const CmdArgs& a, const CmdLine&)
+{
+  reportEvents = a.get(0, reportEvents) != 0;
+  reportState = a.get(1, reportState) != 0;
+  return CmdResult::Ok;
+}
+
+// PING [T=<token>]: "pong <token> t=<device us>" before the OK, for round-trip benchmarks
+static constexpr CmdArgSpec PING_ARGS[] = { { "T", Cmd::parseU32Dec, false } };
+
+static void sendPong(uint32_t token)
+{
+  const uint32_t now = Device::nowUs();
+  if (Device::framed()) {
+    uint8_t msg[9] = { (uint8_t)FrameOp::Pong };
+    Frame::putU32le(msg + 1, token);
+    Frame::putU32le(msg + 5, now);
+    Device::writeFrame(msg, sizeof(msg));
+  } else {
+    Device::printf("pong %lu t=%lu\n", (unsigned long)token, (unsigned long)now);
+  }
+}
+
+static CmdResult cmdPing(const CmdArgs& a, const CmdLine&)
+{
+  sendPong(a.get(0, 0));
+  return CmdResult::Ok;
+}
+
+// TRIGGER [MS=<1-1000>]: pulse LOOPBACK_PIN low; replies "trigger t=<device us>" before the OK
+static constexpr CmdArgSpec TRIGGER_ARGS[] = { { "MS", Cmd::parseU16Dec, false } };
+
+static CmdResult startTrigger(uint32_t ms)
+{
+  if (ms == 0 || ms > 1000) return CmdResult::Err;
+  const uint32_t now = Device::nowUs();
+  if (!Device::trigger((uint16_t)ms, now)) return CmdResult::Err;
+
+  if (Device::framed()) {
+    uint8_t msg[5] = { (uint8_t)FrameOp::Triggered };
+    Frame::putU32le(msg + 1, now);
+    Device::writeFrame(msg, sizeof(msg));
+  } else {
+    Device::printf("trigger t=%lu\n", (unsigned long)now);
+  }
+  return CmdResult::Ok;
+}
+
+static CmdResult cmdTrigger(const CmdArgs& a, const CmdLine&)
+{
+  return startTrigger(a.get(0, 50));
+}
+
+// "scene buttons=<n> crc=<hex>" ahead of the OK, the host compares crc with what it would send
+static void sendSceneInfo(const Scene& scene)
+{
+  const uint32_t crc = SceneStore::crc(scene);
+  if (Device::framed()) {
+    uint8_t msg[6] = { (uint8_t)FrameOp::SceneInfo, Board::buttons };
+    Frame::putU32le(msg + 2, crc);
+    Device::writeFrame(msg, sizeof(msg));
+  } else {
+    Device::printf("scene buttons=%u crc=%08lx\n", (unsigned)Board::buttons, (unsigned long)crc);
+  }
+}
+
+// SAVE_SCENE: current colors + brightness become the power-on state
+static CmdResult saveScene()
+{
+  Led::sync(); // with LED_CORE1, let queued changes land first
+  const Scene scene = SceneStore::capture();
+  if (!SceneStore::save(scene)) return CmdResult::Err;
+  savedScene = scene;
+  haveScene = true;
+  sendSceneInfo(scene);
+  return CmdResult::Ok;
+}
+
+// LOAD_SCENE: show the saved scene again, ERR if there is none
+static CmdResult loadScene()
+{
+  if (!haveScene) return CmdResult::Err;
+  SceneStore::apply(savedScene);
+  sendSceneInfo(savedScene);
+  return CmdResult::Ok;
+}
+
+// CLEAR_SCENE: back to starting dark
+static CmdResult clearScene()
+{
+  if (!SceneStore::clear()) return CmdResult::Err;
+  haveScene = false;
+  return CmdResult::Ok;
+}
+
+static CmdResult cmdSaveScene(const CmdArgs&, const CmdLine&) { return saveScene(); }
+static CmdResult cmdLoadScene(const CmdArgs&, const CmdLine&) { return loadScene(); }
+static CmdResult cmdClearScene(const CmdArgs&, const CmdLine&) { return clearScene(); }
+
+// longest event line, "released 255 t=4294967295 s=4294967295\n"; its frame is shorter
+static constexpr size_t EVENT_TX_MAX = 48;
+
+// next seq an EVENTS replay still has to send, 0 = no replay going out
+static uint32_t replayNext = 0;
+
+static void writeEvent(const LoggedEvent& e)
+{
+  if (Device::framed()) {
+    uint8_t msg[10] = { e.op, e.id };
+    Frame::putU32le(msg + 2, e.timeUs);
+    Frame::putU32le(msg + 6, e.seq);
+    Device::writeFrame(msg, sizeof(msg));
+  } else {
+    const char* kind = e.op == (uint8_t)FrameOp::Chord
+                           ? "chord"
+                           : ButtonEvents::name((ButtonEvent)(e.op - (uint8_t)FrameOp::Pressed));
+    Device::printf("%s %u t=%lu s=%lu\n", kind, (unsigned)e.id, (unsigned long)e.timeUs, (unsigned long)e.seq);
+  }
+}
+
+void Commands::sendEvent(const LoggedEvent& e)
+{
+  if (replayNext) return;
+  writeEvent(e);
+}
+
+// an event that falls out of the log before its turn is skipped, the host sees the gap
+// and asks again
+void Commands::poll()
+{
+  LoggedEvent e;
+  while (replayNext) {
+    if (replayNext > EventLog::last()) {
+      replayNext = 0;
+      return;
+    }
+    if (Device::txFree() < EVENT_TX_MAX) return; // the ring drains with this pass's flush
+    if (EventLog::get(replayNext, e)) writeEvent(e);
+    replayNext++;
+  }
+}
+
+bool Commands::replaying()
+{
+  return replayNext != 0;
+}
+
+// "events next=<seq> last=<seq> lost=<n> hwm=<n>", then every logged event from next on, as
+// fast as the TX ring takes them (see poll()); live events queue up behind the replay.
+// lost = events after `since` that already fell out of the log; without since nothing is
+// replayed and next = last + 1 tells the host where the live stream continues.
+static CmdResult replayEvents(bool replay, uint32_t since)
+{
+  const uint32_t last = EventLog::last();
+  uint32_t next = last + 1;
+  uint32_t lost = 0;
+  if (replay && since < last) {
+    next = since + 1;
+    if (next < EventLog::oldest()) {
+      lost = EventLog::oldest() - next;
+      next = EventLog::oldest();
+    }
+  }
+
+  if (Device::framed()) {
+    uint8_t msg[15] = { (uint8_t)FrameOp::EventInfo };
+    Frame::putU32le(msg + 1, next);
+    Frame::putU32le(msg + 5, last);
+    Frame::putU32le(msg + 9, lost);
+    msg[13] = (uint8_t)EventLog::highWater();
+    msg[14] = (uint8_t)(EventLog::highWater() >> 8);
+    Device::writeFrame(msg, sizeof(msg));
+  } else {
+    Device::printf("events next=%lu last=%lu lost=%lu hwm=%lu\n", (unsigned long)next, (unsigned long)last,
+                      (unsigned long)lost, (unsigned long)EventLog::highWater());
+  }
+
+  replayNext = next <= last ? next : 0;
+  Commands::poll();
+  return CmdResult::Ok;
+}
+
+static CmdResult stageFrame(uint16_t id)
+{
+  staged = true;
+  stagedId = id;
+  Led::hold((uint32_t)STAGE_TIMEOUT_MS * 1000u);
+  return CmdResult::Ok;
+}
+
+// a stale id (host restarted, STAGE lost) still shows the frame, but answers ERR
+static CmdResult commitFrame(uint16_t id)
+{
+  const bool match = staged && id == stagedId;
+  staged = false;
+  Led::release();
+  return match ? CmdResult::Ok : CmdResult::Err;
+}
+
+// STAGE ID=<id> ... COMMIT ID=<id>: stage on every panel, then commit them all at once
+static constexpr CmdArgSpec FRAME_ID_ARGS[] = { { "ID", Cmd::parseU16Dec, true } };
+static CmdResult cmdStage(const CmdArgs& a, const CmdLine&) { return stageFrame((uint16_t)a.value[0]); }
+static CmdResult cmdCommit(const CmdArgs& a, const CmdLine&) { return commitFrame((uint16_t)a.value[0]); }
+
+// ACK S=<seq>: the host has every event up to seq
+static constexpr CmdArgSpec ACK_ARGS[] = { { "S", Cmd::parseU32Dec, true } };
+static CmdResult cmdAck(const CmdArgs& a, const CmdLine&)
+{
+  EventLog::ack(a.value[0]);
+  return CmdResult::Ok;
+}
+
+// EVENTS [SINCE=<seq>]
+static constexpr CmdArgSpec EVENTS_ARGS[] = { { "SINCE", Cmd::parseU32Dec, false } };
+static CmdResult cmdEvents(const CmdArgs& a, const CmdLine&)
+{
+  return replayEvents(a.has(0), a.value[0]);
+}
+
+#if HOTKEY_STATS
+// STATS [RESET]: timing histograms and counters, see stats.h
+static CmdResult cmdStats(const CmdArgs&, const CmdLine& line)
+{
+  if (line.count > 1 || (line.count == 1 && (line.tok[0].val || strcasecmp(line.tok[0].key, "RESET") != 0))) {
+    return CmdResult::Err;
+  }
+  if (line.count == 1) Device::resetStats();
+  else Device::printStats();
+  return CmdResult::Ok;
+}
+#endif
+
+static constexpr Command COMMANDS[] = {
+  Cmd::declare("BOOT_BOOTLOADER", cmdBootloader),
+  Cmd::declare("CONFIG", cmdConfig),
+  Cmd::declare("SET_SINGLE", cmdSetSingle, SET_SINGLE_ARGS),
+  Cmd::declareFreeForm("SET_MANY", cmdSetMany),
+  Cmd::declare("SET_FRAME", cmdSetFrame, SET_FRAME_ARGS),
+  Cmd::declare("SET_EFFECT", cmdSetEffect, SET_EFFECT_ARGS),
+  Cmd::declareFreeForm("PROTO", cmdProto),
+  Cmd::declare("FLUSH", cmdFlush),
+  Cmd::declare("SET_BRIGHTNESS", cmdSetBrightness, SET_BRIGHTNESS_ARGS),
+  Cmd::declare("SET_ALL", cmdSetAll, SET_ALL_ARGS),
+  Cmd::declare("REPORT", cmdReport, REPORT_ARGS),
+  Cmd::declare("PING", cmdPing, PING_ARGS),
+  Cmd::declare("TRIGGER", cmdTrigger, TRIGGER_ARGS),
+  Cmd::declare("SAVE_SCENE", cmdSaveScene),
+  Cmd::declare("LOAD_SCENE", cmdLoadScene),
+  Cmd::declare("CLEAR_SCENE", cmdClearScene),
+  Cmd::declare("ACK", cmdAck, ACK_ARGS),
+  Cmd::declare("STAGE", cmdStage, FRAME_ID_ARGS),
+  Cmd::declare("COMMIT", cmdCommit, FRAME_ID_ARGS),
+  Cmd::declare("EVENTS", cmdEvents, EVENTS_ARGS),
+#if HOTKEY_STATS
+  Cmd::declareFreeForm("STATS", cmdStats),
+#endif
+};
+
+static constexpr CommandTable<sizeof(COMMANDS) / sizeof(COMMANDS[0]), 64> commandTable(COMMANDS);
+static_assert(commandTable.perfect(), "no collision-free seed for the command table, grow Slots");
+
+CmdResult Commands::handleLine(char* line)
+{
+  CmdLine cmdLine;
+  if (!Cmd::lex(line, cmdLine)) return CmdResult::Err;
+
+  const Command* command = commandTable.find(cmdLine.name, cmdLine.nameLen);
+  if (!command) return CmdResult::Unknown;
+  return Cmd::run(*command, cmdLine);
+}
+
+void Commands::begin()
+{
+  ::haveScene = SceneStore::load(savedScene);
+  if (::haveScene) SceneStore::apply(savedScene);
+}
+
+void Commands::onConnect()
+{
+  ::reportEvents = true;
+  ::reportState = false;
+  replayNext = 0;
+
+  // whatever the reset below changes goes out as one show
+  staged = false;
+  Led::hold((uint32_t)STAGE_TIMEOUT_MS * 1000u);
+  if (::haveScene) {
+    SceneStore::apply(savedScene);
+  } else {
+    Led::setAllLed(0x000000);
+    Led::setBrightness(BRIGHTNESS);
+  }
+  Led::release();
+}
+
+bool Commands::takeSwitchToFramed()
+{
+  const bool on = switchToFramed;
+  switchToFramed = false;
+  return on;
+}
+
+bool Commands::reportEvents()
+{
+  return ::reportEvents;
+}
+
+bool Commands::reportState()
+{
+  return ::reportState;
+}
+
+bool Commands::haveScene()
+{
+  return ::haveScene;
+}
+
+// frame = [op] [seq] [args...], already crc-checked
+CmdResult Commands::handleFrame(const uint8_t* frame, size_t len)
+{
+  if (len < 2) return CmdResult::Err;
+  const uint8_t* arg = frame + 2;
+  const size_t argLen = len - 2;
+
+  switch ((FrameOp)frame[0]) {
+    case FrameOp::SetSingle:
+      if (argLen != 4) return CmdResult::Err;
+      Led::setLed(arg[0], Frame::rgb24(arg + 1));
+      return CmdResult::Ok;
+
+    case FrameOp::SetAll:
+      if (argLen != 3) return CmdResult::Err;
+      Led::setAllLed(Frame::rgb24(arg));
+      return CmdResult::Ok;
+
+    case FrameOp::SetMany: {
+      if (argLen == 0 || argLen % 4 != 0 || argLen / 4 > Board::buttons) return CmdResult::Err;
+      uint8_t ids[Board::buttons];
+      uint32_t colors[Board::buttons];
+      const uint8_t n = (uint8_t)(argLen / 4);
+      for (uint8_t i = 0; i < n; i++) {
+        ids[i] = arg[i * 4];
+        colors[i] = Frame::rgb24(arg + i * 4 + 1);
+      }
+      Led::setLeds(ids, colors, n);
+      return CmdResult::Ok;
+    }
+
+    case FrameOp::SetEffect: {
+      if (argLen != 14 || arg[1] > (uint8_t)LedEffect::Chase) return CmdResult::Err;
+      LedEffectSpec fx;
+      fx.mode = (LedEffect)arg[1];
+      fx.color = Frame::rgb24(arg + 2);
+      fx.color2 = Frame::rgb24(arg + 5);
+      fx.periodMs = Frame::u16le(arg + 8);
+      fx.durationMs = Frame::u16le(arg + 10);
+      fx.phaseMs = Frame::u16le(arg + 12);
+      if (fx.periodMs == 0) return CmdResult::Err;
+      Led::setEffect(arg[0], fx);
+      return CmdResult::Ok;
+    }
+
+    case FrameOp::SetBrightness:
+      if (argLen != 2) return CmdResult::Err;
+      if (arg[0] == 0xFF) Led::setBrightness(arg[1]);
+      else if (arg[0] < Board::buttons) Led::setButtonBrightness(arg[0], arg[1]);
+      else return CmdResult::Err;
+      return CmdResult::Ok;
+
+    case FrameOp::Report:
+      if (argLen != 2 || (arg[0] > 1 && arg[0] != 0xFF) || (arg[1] > 1 && arg[1] != 0xFF)) return CmdResult::Err;
+      if (arg[0] != 0xFF) ::reportEvents = arg[0] != 0;
+      if (arg[1] != 0xFF) ::reportState = arg[1] != 0;
+      return CmdResult::Ok;
+
+    case FrameOp::Ping:
+      if (argLen != 4) return CmdResult::Err;
+      sendPong(Frame::u32le(arg));
+      return CmdResult::Ok;
+
+    case FrameOp::Trigger:
+      if (argLen != 2) return CmdResult::Err;
+      return startTrigger(Frame::u16le(arg));
+
+    case FrameOp::Flush:
+      if (argLen != 0) return CmdResult::Err;
+      Led::flush();
+      return CmdResult::Ok;
+
+    case FrameOp::Stage:
+      return argLen == 2 ? stageFrame(Frame::u16le(arg)) : CmdResult::Err;
+
+    case FrameOp::Commit:
+      return argLen == 2 ? commitFrame(Frame::u16le(arg)) : CmdResult::Err;
+
+    case FrameOp::SaveScene:
+      return argLen == 0 ? saveScene() : CmdResult::Err;
+
+    case FrameOp::LoadScene:
+      return argLen == 0 ? loadScene() : CmdResult::Err;
+
+    case FrameOp::ClearScene:
+      return argLen == 0 ? clearScene() : CmdResult::Err;
+
+    case FrameOp::EventAck:
+      if (argLen != 4) return CmdResult::Err;
+      EventLog::ack(Frame::u32le(arg));
+      return CmdResult::Ok;
+
+    case FrameOp::Events:
+      if (argLen != 0 && argLen != 4) return CmdResult::Err;
+      return replayEvents(argLen == 4, argLen == 4 ? Frame::u32le(arg) : 0);
+
+    case FrameOp::Text:
+      if (argLen != 0) return CmdResult::Err;
+      return CmdResult::Ok; // caller switches after the ack
+
+    default:
+      return CmdResult::Unknown;
+  }
+}
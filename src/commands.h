@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#include "command.h"
+#include "eventlog.h"
+
+// STAGE without a COMMIT shows the staged changes anyway after this long
+#ifndef STAGE_TIMEOUT_MS
+  #define STAGE_TIMEOUT_MS 250
+#endif
+
+// The firmware's command set, text (the COMMANDS table) and binary (FrameOp), and the session
+// state it changes. Free of hardware: handlers reach the LEDs through Led and everything else
+// through Device, so the native bench runs this exact table against stubs.
+class Commands {
+public:
+  static void begin();     // read the saved scene and show it
+  static void onConnect(); // REPORT and STAGE back to defaults, saved scene (or dark) in one show
+
+  static CmdResult handleLine(char* line);                        // without the "#<seq>" tag
+  static CmdResult handleFrame(const uint8_t* frame, size_t len); // [op] [seq] [args...], crc-checked
+
+  static bool takeSwitchToFramed(); // PROTO BIN went through, switch once its OK is out
+
+  // EVENTS SINCE= sends what fits in the TX ring, poll() sends the rest on later loop passes
+  static void poll();
+  static bool replaying();
+
+  static bool reportEvents();
+  static bool reportState();
+  static bool haveScene();
+
+  // "<kind> <id> t=<us> s=<seq>" or its frame, the same live and on replay; held back while a
+  // replay is going out, which picks it up from the log in seq order
+  static void sendEvent(const LoggedEvent& e);
+};
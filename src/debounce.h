@@ -0,0 +1,147 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+#ifndef DEBOUNCE_MS
+  #define DEBOUNCE_MS 20
+#endif
+
+#define DEBOUNCE_DEFER 0 // report once the input was stable for DEBOUNCE_MS
+#define DEBOUNCE_EAGER 1 // report the first edge, then ignore the pin for DEBOUNCE_MS
+
+#ifndef DEBOUNCE_MODE
+  #define DEBOUNCE_MODE DEBOUNCE_DEFER
+#endif
+
+// Debounce time base. Windows are counted in whole ticks (jitter < 1 tick).
+#ifndef DEBOUNCE_TICK_US
+  #define DEBOUNCE_TICK_US 1000
+#endif
+
+static constexpr uint32_t DEBOUNCE_US = (uint32_t)DEBOUNCE_MS * 1000u;
+
+// N independent counters, one per bit position, stored bit-sliced:
+// bit[k] holds bit k of every counter, so each operation touches all lanes at once.
+template <uint8_t Bits>
+struct VerticalCounter {
+  uint32_t bit[Bits]{};
+
+  void clear(uint32_t lanes) {
+    for (auto& b : bit) b &= ~lanes;
+  }
+
+  void increment(uint32_t lanes) {
+    uint32_t carry = lanes;
+    for (auto& b : bit) {
+      const uint32_t next = b & carry;
+      b ^= carry;
+      carry = next;
+    }
+  }
+
+  uint32_t equals(uint32_t value) const {
+    uint32_t eq = ~0u;
+    for (uint8_t k = 0; k < Bits; k++) eq &= ((value >> k) & 1u) ? bit[k] : ~bit[k];
+    return eq;
+  }
+};
+
+template <uint8_t Bits>
+struct DebounceState {
+  uint32_t stable = 0;
+  uint32_t active = 0; // defer: lanes differing from stable, eager: lanes locked out
+  VerticalCounter<Bits> count;
+};
+
+struct DeferDebounce {
+  // Lanes that differed at the last update count up; reaching the window flips them.
+  template <typename S>
+  static uint32_t update(S& s, uint32_t raw, uint32_t ticks, uint32_t window) {
+    uint32_t counting = s.active;
+    uint32_t reached = 0;
+    for (uint32_t t = 0; t < ticks && t < window && counting; t++) {
+      s.count.increment(counting);
+      const uint32_t done = s.count.equals(window) & counting;
+      reached |= done;
+      counting &= ~done;
+    }
+    s.stable ^= reached;
+
+    // any sample back at the stable level restarts that lane's window
+    s.active = raw ^ s.stable;
+    s.count.clear(~s.active | reached);
+    return reached;
+  }
+};
+
+struct EagerDebounce {
+  // Edges on unlocked lanes report immediately and start a lockout window.
+  template <typename S>
+  static uint32_t update(S& s, uint32_t raw, uint32_t ticks, uint32_t window) {
+    uint32_t locked = s.active;
+    for (uint32_t t = 0; t < ticks && t < window && locked; t++) {
+      s.count.increment(locked);
+      locked &= ~s.count.equals(window);
+    }
+
+    const uint32_t edges = (raw ^ s.stable) & ~locked;
+    s.stable ^= edges;
+
+    s.active = locked | edges;
+    s.count.clear(~locked);
+    return edges;
+  }
+};
+
+using DefaultDebounce =
+    std::conditional_t<DEBOUNCE_MODE == DEBOUNCE_EAGER, EagerDebounce, DeferDebounce>;
+
+// Bit-parallel debouncer for up to 32 inputs (bit i = input i), Lanes = inputs in use.
+// Cost per update is a handful of word ops per elapsed tick, independent of input count.
+template <typename Policy = DefaultDebounce, uint32_t WindowUs = DEBOUNCE_US,
+          uint32_t TickUs = DEBOUNCE_TICK_US, uint32_t Lanes = 0xFFFFFFFFu>
+class Debouncer {
+  static constexpr uint32_t WINDOW_TICKS = (WindowUs / TickUs) ? (WindowUs / TickUs) : 1;
+
+  static constexpr uint8_t bitsFor(uint32_t v) {
+    uint8_t n = 1;
+    while ((v >> n) != 0) n++;
+    return n;
+  }
+
+public:
+  void reset(uint32_t raw, uint32_t nowUs) {
+    s_ = State{};
+    s_.stable = raw & Lanes;
+    lastTickUs_ = nowUs;
+  }
+
+  // Returns the lanes whose debounced state changed; read the new state from pressed().
+  uint32_t update(uint32_t raw, uint32_t nowUs) {
+    const int32_t elapsed = (int32_t)(nowUs - lastTickUs_);
+    uint32_t ticks = 0;
+    if (elapsed > 0) { // an edge snapshot may be older than the last poll
+      ticks = (uint32_t)elapsed / TickUs;
+      lastTickUs_ += ticks * TickUs;
+    }
+    return Policy::update(s_, raw & Lanes, ticks, WINDOW_TICKS);
+  }
+
+  uint32_t pressed() const { return s_.stable; }
+
+  // Earliest tick at which a settling (defer) or locked-out (eager) lane completes its
+  // window. Between edges the input can't change, so nothing else needs a wake-up.
+  bool nextDue(uint32_t& dueUs) const {
+    if (!s_.active) return false;
+    uint32_t most = WINDOW_TICKS - 1; // furthest count among active lanes
+    while (most > 0 && !(s_.count.equals(most) & s_.active)) most--;
+    dueUs = lastTickUs_ + (WINDOW_TICKS - most) * TickUs;
+    return true;
+  }
+
+private:
+  using State = DebounceState<bitsFor(WINDOW_TICKS)>;
+
+  State s_;
+  uint32_t lastTickUs_ = 0;
+};
@@ -0,0 +1,149 @@
+#include "device.h"
+
+#include <Arduino.h>
+#include <cstdarg>
+#include <cstring>
+
+#include "board.h"
+#include "bootloader.h"
+#include "buttons.h"
+#include "chords.h"
+#include "commands.h"
+#include "debounce.h"
+#include "eventlog.h"
+#include "events.h"
+#include "hidreport.h"
+#include "idle.h"
+#include "led.h"
+#include "loopback.h"
+#include "stats.h"
+#include "usbserial.h"
+
+extern UsbSerial usbSerial;
+extern Buttons buttons;
+static Bootloader bootloader;
+
+bool Device::framed()
+{
+  return usbSerial.framed();
+}
+
+void Device::printf(const char* fmt, ...)
+{
+  va_list ap;
+  va_start(ap, fmt);
+  UsbSerial::vprintf(fmt, ap);
+  va_end(ap);
+}
+
+void Device::println(const char* s)
+{
+  UsbSerial::println(s);
+}
+
+void Device::writeFrame(const uint8_t* payload, size_t len)
+{
+  UsbSerial::writeFrame(payload, len);
+}
+
+size_t Device::txFree()
+{
+  return UsbSerial::txFree();
+}
+
+uint32_t Device::nowUs()
+{
+  return Buttons::nowUs();
+}
+
+void Device::rebootToBootloader()
+{
+  UsbSerial::println("Rebooting to bootloader...");
+  UsbSerial::flush();
+  delay(50);
+  bootloader.loadBootloader();
+}
+
+bool Device::trigger(uint16_t ms, uint32_t nowUs)
+{
+  return Loopback::trigger(ms, nowUs);
+}
+
+#define STR_HELPER(x) #x
+#define STR(x) STR_HELPER(x)
+
+#define STRVA_HELPER(...) #__VA_ARGS__
+#define STRVA(...) STRVA_HELPER(__VA_ARGS__)
+
+void Device::printConfig()
+{
+  UsbSerial::println("=== CONFIG ===");
+  
+  // Core settings
+  UsbSerial::printf("SERIAL_BAUDRATE=%s\n", STR(SERIAL_BAUDRATE));
+  UsbSerial::printf("BRIGHTNESS=%s\n", STR(BRIGHTNESS));
+  UsbSerial::printf("HOTKEY_BUTTONS=%u\n", (unsigned)Board::buttons);
+  UsbSerial::printf("BUTTON_SCAN_IRQ=%s\n", STR(BUTTON_SCAN_IRQ));
+  UsbSerial::printf("IDLE_MAX_US=%s\n", STR(IDLE_MAX_US));
+  UsbSerial::printf("DEBOUNCE_MS=%s\n", STR(DEBOUNCE_MS));
+  UsbSerial::printf("DEBOUNCE_MODE=%s\n", DEBOUNCE_MODE == DEBOUNCE_EAGER ? "eager" : "defer");
+  UsbSerial::printf("BUTTON_HOLD_MS=%s\n", STR(BUTTON_HOLD_MS));
+  UsbSerial::printf("BUTTON_REPEAT_MS=%s\n", STR(BUTTON_REPEAT_MS));
+
+  // Chords (mask of buttons held together -> action)
+  for (uint8_t i = 0; i < CHORD_COUNT; i++) {
+    UsbSerial::printf("CHORD%u=%lx,%ums,%s\n", (unsigned)i, (unsigned long)CHORDS[i].mask,
+                      (unsigned)CHORDS[i].holdMs,
+                      CHORDS[i].action == ChordAction::Bootloader ? "bootloader" : "report");
+  }
+
+  // LED-related
+  UsbSerial::printf("LED_PIN=%u\n", (unsigned)Board::ledPin);
+
+  UsbSerial::printf("LED_FRAME_HZ=%s\n", STR(LED_FRAME_HZ));
+  UsbSerial::printf("LED_CORE1=%s\n", STR(LED_CORE1));
+  UsbSerial::printf("LED_GAMMA=%s\n", STR(LED_GAMMA));
+  UsbSerial::printf("LED_PIO=%s\n", STR(LED_PIO));
+  UsbSerial::printf("LED_DRIVER=%s\n", Led::driver());
+  UsbSerial::printf("HOTKEY_HID=%s\n", STR(HOTKEY_HID));
+  UsbSerial::printf("EVENT_LOG_SIZE=%s\n", STR(EVENT_LOG_SIZE));
+  UsbSerial::printf("STAGE_TIMEOUT_MS=%s\n", STR(STAGE_TIMEOUT_MS));
+  UsbSerial::printf("SCENE=%s\n", Commands::haveScene() ? "saved" : "none");
+  UsbSerial::printf("HOTKEY_STATS=%s\n", STR(HOTKEY_STATS));
+  UsbSerial::printf("LOOPBACK_PIN=%s\n", STR(LOOPBACK_PIN));
+
+  UsbSerial::printf("LEDS_PER_BUTTON=%u\n", (unsigned)Board::ledsPerButton);
+
+  // Button pin map (macro text + resolved values)
+  UsbSerial::printf("HOTKEY_BUTTON_PINS_MAP=%s\n", STRVA(HOTKEY_BUTTON_PINS_MAP));
+
+  UsbSerial::println("HOTKEY_BUTTON_PINS=[");
+  for (uint8_t i = 0; i < Board::buttons; i++) {
+    UsbSerial::printf("%u", (unsigned)Board::pins[i]);
+    if (i + 1 < Board::buttons) UsbSerial::println(",");
+  }
+  UsbSerial::println("]");
+}
+
+
+void Device::printStats()
+{
+#if HOTKEY_STATS
+  UsbSerial::println("=== STATS ===");
+  Stats::print();
+  UsbSerial::printf("rx_overflows=%lu\n", (unsigned long)usbSerial.rxOverflows());
+  UsbSerial::printf("rx_dropped=%lu\n", (unsigned long)usbSerial.rxDropped());
+  UsbSerial::printf("bad_frames=%lu\n", (unsigned long)usbSerial.badFrames());
+  UsbSerial::printf("tx_dropped=%lu\n", (unsigned long)UsbSerial::txDropped());
+  UsbSerial::printf("edge_overruns=%lu\n", (unsigned long)buttons.overruns());
+  UsbSerial::printf("events_overwritten=%lu\n", (unsigned long)EventLog::overwritten());
+  UsbSerial::printf("event_backlog_hwm=%lu\n", (unsigned long)EventLog::highWater());
+#endif
+}
+
+void Device::resetStats()
+{
+#if HOTKEY_STATS
+  Stats::reset();
+#endif
+}
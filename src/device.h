@@ -0,0 +1,25 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// What the command handlers (commands.cpp) need from the board besides the LEDs: the reply
+// channel, the clock and a few one-off actions. device.cpp maps it onto UsbSerial, Loopback,
+// Bootloader and Stats; bench/stubs.cpp stands in on the host.
+class Device {
+public:
+  // replies and reports, staged in the TX ring like everything else
+  static bool framed(); // PROTO BIN is active: reports go out as frames
+  static void printf(const char* fmt, ...);
+  static void println(const char* s);
+  static void writeFrame(const uint8_t* payload, size_t len);
+  static size_t txFree(); // bytes that still fit before this loop pass's flush
+
+  static uint32_t nowUs(); // button clock, events and pongs are stamped with it
+
+  static void rebootToBootloader(); // doesn't return on the RP2040
+  static bool trigger(uint16_t ms, uint32_t nowUs); // LOOPBACK_PIN pulse, false if disabled or busy
+
+  static void printConfig();
+  static void printStats(); // STATS, HOTKEY_STATS builds only
+  static void resetStats();
+};
@@ -0,0 +1,37 @@
+#include "eventlog.h"
+
+LoggedEvent EventLog::ring_[EventLog::SIZE];
+uint32_t EventLog::next_ = 1;
+uint32_t EventLog::acked_ = 0;
+uint32_t EventLog::highWater_ = 0;
+uint32_t EventLog::overwritten_ = 0;
+
+const LoggedEvent& EventLog::append(uint8_t op, uint8_t id, uint32_t timeUs) {
+  const uint32_t seq = next_++;
+  if (seq > SIZE && acked_ < seq - SIZE) overwritten_++; // the slot still held an unacked event
+
+  LoggedEvent& e = ring_[seq & (SIZE - 1)];
+  e = LoggedEvent{ seq, timeUs, op, id };
+
+  if (unacked() > highWater_) highWater_ = unacked();
+  return e;
+}
+
+uint32_t EventLog::oldest() {
+  return next_ > SIZE ? next_ - SIZE : 1;
+}
+
+bool EventLog::get(uint32_t seq, LoggedEvent& out) {
+  if (seq == 0 || seq >= next_ || seq < oldest()) return false;
+  out = ring_[seq & (SIZE - 1)];
+  return true;
+}
+
+void EventLog::ack(uint32_t seq) {
+  if (seq > last()) seq = last(); // acking the future would hide real loss
+  if (seq > acked_) acked_ = seq;
+}
+
+void EventLog::resetHighWater() {
+  highWater_ = unacked();
+}
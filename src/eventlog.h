@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+
+// Every reported button/chord event, kept until it falls out of the ring, so the host can
+// get back whatever it missed (USB re-enumerating, TX ring full, host busy). Must be a
+// power of two.
+#ifndef EVENT_LOG_SIZE
+  #define EVENT_LOG_SIZE 64
+#endif
+
+struct LoggedEvent {
+  uint32_t seq;    // 1, 2, 3, ... since boot, never reused
+  uint32_t timeUs; // as reported
+  uint8_t op;      // FrameOp::Pressed .. FrameOp::Chord
+  uint8_t id;      // button, or chord index
+};
+
+class EventLog {
+public:
+  static constexpr uint32_t SIZE = EVENT_LOG_SIZE;
+  static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "EVENT_LOG_SIZE must be a power of two");
+
+  static const LoggedEvent& append(uint8_t op, uint8_t id, uint32_t timeUs); // overwrites the oldest
+  static bool get(uint32_t seq, LoggedEvent& out); // false once it fell out (or not logged yet)
+
+  static uint32_t last() { return next_ - 1; } // 0 = nothing logged yet
+  static uint32_t oldest();                    // first seq still in the ring
+
+  // host has everything up to seq; what is left unacknowledged is the connection's backlog
+  static void ack(uint32_t seq);
+  static uint32_t acked() { return acked_; }
+  static uint32_t unacked() { return last() - acked_; }
+
+  static uint32_t highWater() { return highWater_; } // max unacked since resetHighWater()
+  static uint32_t overwritten() { return overwritten_; } // dropped before they were acked
+  static void resetHighWater(); // on connect
+
+private:
+  static LoggedEvent ring_[SIZE];
+  static uint32_t next_;
+  static uint32_t acked_;
+  static uint32_t highWater_;
+  static uint32_t overwritten_;
+};
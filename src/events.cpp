@@ -0,0 +1,61 @@
+#include "events.h"
+
+const char* ButtonEvents::name(ButtonEvent ev) {
+  switch (ev) {
+    case ButtonEvent::Pressed:  return "pressed";
+    case ButtonEvent::Released: return "released";
+    case ButtonEvent::Held:     return "held";
+    case ButtonEvent::Repeat:   return "repeat";
+  }
+  return "?";
+}
+
+void ButtonEvents::update(uint32_t changed, uint32_t pressed, uint32_t nowUs, Emit emit) {
+  for (uint32_t m = changed & Board::buttonMask; m; m &= m - 1) {
+    const uint8_t b = (uint8_t)__builtin_ctz(m);
+    const uint32_t bit = 1u << b;
+
+    if (pressed & bit) {
+      emit(ButtonEvent::Pressed, b, nowUs);
+      if (HOLD_US) {
+        dueUs_[b] = nowUs + HOLD_US;
+        held_[b] = false;
+        timed_ |= bit;
+      }
+    } else {
+      timed_ &= ~bit;
+      emit(ButtonEvent::Released, b, nowUs);
+    }
+  }
+}
+
+void ButtonEvents::poll(uint32_t nowUs, Emit emit) {
+  for (uint32_t m = timed_; m; m &= m - 1) {
+    const uint8_t b = (uint8_t)__builtin_ctz(m);
+    const uint32_t due = dueUs_[b];
+    if ((int32_t)(nowUs - due) < 0) continue;
+
+    emit(held_[b] ? ButtonEvent::Repeat : ButtonEvent::Held, b, due);
+    held_[b] = true;
+
+    if (!REPEAT_US) {
+      timed_ &= ~(1u << b);
+      continue;
+    }
+
+    // a late loop drops missed repeats instead of bursting them, the phase stays put
+    uint32_t next = due + REPEAT_US;
+    while ((int32_t)(nowUs - next) >= 0) next += REPEAT_US;
+    dueUs_[b] = next;
+  }
+}
+
+bool ButtonEvents::nextDue(uint32_t& dueUs) const {
+  if (!timed_) return false;
+  dueUs = dueUs_[__builtin_ctz(timed_)];
+  for (uint32_t m = timed_ & (timed_ - 1); m; m &= m - 1) {
+    const uint32_t due = dueUs_[__builtin_ctz(m)];
+    if ((int32_t)(due - dueUs) < 0) dueUs = due;
+  }
+  return true;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <cstdint>
+
+#include "board.h"
+
+// Long press after this many ms held, 0 = no held/repeat events
+#ifndef BUTTON_HOLD_MS
+  #define BUTTON_HOLD_MS 500
+#endif
+
+// Auto-repeat period once held, 0 = held event only
+#ifndef BUTTON_REPEAT_MS
+  #define BUTTON_REPEAT_MS 100
+#endif
+
+enum class ButtonEvent : uint8_t { Pressed, Released, Held, Repeat };
+
+// Turns debounced edges into press/release/hold/repeat events.
+// Timestamps are device time (time_us_32): the edge sample for press/release, the scheduled
+// deadline for held/repeat, so repeats don't drift with loop jitter.
+class ButtonEvents {
+public:
+  using Emit = void (*)(ButtonEvent ev, uint8_t button, uint32_t timeUs);
+
+  static const char* name(ButtonEvent ev);
+
+  // changed/pressed as returned by the debouncer, nowUs = time of that sample
+  void update(uint32_t changed, uint32_t pressed, uint32_t nowUs, Emit emit);
+
+  // held/repeat deadlines that passed by nowUs
+  void poll(uint32_t nowUs, Emit emit);
+
+  bool nextDue(uint32_t& dueUs) const; // earliest pending held/repeat deadline
+
+private:
+  static constexpr uint32_t HOLD_US = (uint32_t)BUTTON_HOLD_MS * 1000u;
+  static constexpr uint32_t REPEAT_US = (uint32_t)BUTTON_REPEAT_MS * 1000u;
+
+  uint32_t timed_ = 0;           // buttons with a pending held/repeat deadline
+  uint32_t dueUs_[Board::buttons] = {};
+  bool held_[Board::buttons] = {};
+};
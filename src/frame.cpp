@@ -0,0 +1,62 @@
+#include "frame.h"
+
+uint8_t Frame::crc8(const uint8_t* data, size_t len) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for (uint8_t b = 0; b < 8; b++) {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+size_t Frame::encode(const uint8_t* payload, size_t len, uint8_t* out) {
+  const uint8_t crc = crc8(payload, len);
+
+  size_t codeIdx = 0; // where the current block's length byte goes
+  size_t o = 1;
+  uint8_t code = 1;
+
+  for (size_t i = 0; i <= len; i++) {
+    const uint8_t c = (i < len) ? payload[i] : crc;
+    if (c == 0) {
+      out[codeIdx] = code;
+      codeIdx = o++;
+      code = 1;
+      continue;
+    }
+    out[o++] = c;
+    if (++code == 0xFF) {
+      out[codeIdx] = code;
+      codeIdx = o++;
+      code = 1;
+    }
+  }
+  out[codeIdx] = code;
+  return o;
+}
+
+size_t Frame::decode(const uint8_t* in, size_t len, uint8_t* out, size_t outSize) {
+  size_t o = 0;
+  size_t i = 0;
+
+  while (i < len) {
+    const uint8_t code = in[i++];
+    if (code == 0) return 0;
+
+    for (uint8_t k = 1; k < code; k++) {
+      if (i >= len || o >= outSize || in[i] == 0) return 0;
+      out[o++] = in[i++];
+    }
+    if (code != 0xFF && i < len) {
+      if (o >= outSize) return 0;
+      out[o++] = 0;
+    }
+  }
+
+  // need at least op + crc
+  if (o < 2) return 0;
+  if (crc8(out, o - 1) != out[o - 1]) return 0;
+  return o - 1;
+}
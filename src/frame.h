@@ -0,0 +1,72 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Binary protocol (enabled with the text command "PROTO BIN").
+//
+// Wire format: COBS(payload | crc8(payload)) 0x00
+// Payload:     [op] [body...], multi-byte fields little-endian
+//   host -> device: [op] [seq] [args...]   answered with Ack [seq] [status]
+//   device -> host: [op] [args...]
+enum class FrameOp : uint8_t {
+  SetSingle = 0x10, // [b] [r] [g] [b]
+  SetAll    = 0x11, // [r] [g] [b]
+  SetMany   = 0x12, // ([b] [r] [g] [b]) * n
+  Flush     = 0x13, //
+  SetEffect = 0x14, // [b] [mode] [rgb] [rgb2] [period u16] [duration u16] [phase u16]
+  SetBrightness = 0x15, // [b | 0xFF = global] [level]
+  Report    = 0x16, // [events 0|1] [state 0|1], 0xFF = unchanged
+  Ping      = 0x17, // [token u32], Pong goes out before the Ack
+  Trigger   = 0x18, // [ms u16], pulse LOOPBACK_PIN
+  SaveScene = 0x19, // SceneInfo goes out before the Ack
+  LoadScene = 0x1A, // SceneInfo goes out before the Ack, Err if none saved
+  ClearScene = 0x1B, //
+  EventAck  = 0x1C, // [seq u32], host has every event up to seq
+  Events    = 0x1D, // [since u32] replays what followed, or nothing: EventInfo goes out before the Ack
+  Stage     = 0x1E, // [id u16], LED changes wait for Commit
+  Text      = 0x1F, // back to the text protocol
+  Commit    = 0x20, // [id u16], show the staged frame now, Err for a stale id
+
+  Ack       = 0x80, // [seq] [status]
+  Pressed   = 0x81, // [b] [t u32] [seq u32], t = device time in us, seq see EventLog
+  Released  = 0x82, // [b] [t u32] [seq u32]
+  Held      = 0x83, // [b] [t u32] [seq u32]
+  Repeat    = 0x84, // [b] [t u32] [seq u32]
+  State     = 0x85, // [pressed mask u32] [t u32], after REPORT STATE=1
+  Chord     = 0x86, // [chord index] [t u32] [seq u32]
+  Pong      = 0x87, // [token u32] [t u32]
+  Triggered = 0x88, // [t u32]
+  SceneInfo = 0x89, // [buttons] [crc u32], see SceneStore::crc()
+  EventInfo = 0x8A, // [next u32] [last u32] [lost u32] [high water u16]
+};
+
+enum class FrameStatus : uint8_t { Ok = 0, Err = 1, Unknown = 2 };
+
+class Frame {
+public:
+  static constexpr size_t MAX_PAYLOAD = 160;
+
+  static constexpr size_t maxEncoded(size_t len) { return len + 2 + (len + 1) / 254; }
+
+  static uint8_t crc8(const uint8_t* data, size_t len); // poly 0x07, init 0
+
+  // COBS-encode payload + crc into out (no trailing delimiter), returns encoded length
+  static size_t encode(const uint8_t* payload, size_t len, uint8_t* out);
+
+  // Decode one COBS block (delimiter stripped) and check the crc.
+  // Returns the payload length without crc, 0 for a broken frame.
+  static size_t decode(const uint8_t* in, size_t len, uint8_t* out, size_t outSize);
+
+  // field helpers
+  static constexpr uint32_t rgb24(const uint8_t* p) { return ((uint32_t)p[0] << 16) | ((uint32_t)p[1] << 8) | p[2]; }
+  static constexpr uint16_t u16le(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+  static constexpr uint32_t u32le(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+  }
+  static void putU32le(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+  }
+};
@@ -0,0 +1,75 @@
+#include "hidreport.h"
+
+#if HOTKEY_HID && defined(ARDUINO_ARCH_RP2040)
+
+#include <CoreMutex.h>
+#include <USB.h>
+
+#include "tusb.h"
+
+// the core's HID interrupt endpoint bInterval, 10 ms unless overridden
+int usb_hid_poll_interval = 1;
+
+// vendor page, one 8-byte input report: [pressed u32 le] [time us u32 le]
+static const uint8_t REPORT_DESC[] = {
+  HID_USAGE_PAGE_N(HID_USAGE_PAGE_VENDOR, 2),
+  HID_USAGE(0x01),
+  HID_COLLECTION(HID_COLLECTION_APPLICATION),
+    HID_USAGE(0x02),
+    HID_LOGICAL_MIN(0x00),
+    HID_LOGICAL_MAX_N(0xFF, 2),
+    HID_REPORT_SIZE(8),
+    HID_REPORT_COUNT(8),
+    HID_INPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),
+  HID_COLLECTION_END,
+};
+
+static uint8_t deviceId = 0;
+static uint8_t report[8];
+static bool queued = false;
+static uint32_t sentUs = 0; // the endpoint last took a report
+
+// the endpoint frees up within a poll or two; busy for longer, nobody reads it (hidraw closed)
+static constexpr uint32_t RETRY_US = 8000;
+
+void HidReport::begin() {
+  USB.disconnect();
+  deviceId = USB.registerHIDDevice(REPORT_DESC, sizeof(REPORT_DESC), 20, 0x4850);
+  USB.connect();
+}
+
+void HidReport::send(uint32_t pressed, uint32_t timeUs) {
+  for (uint8_t i = 0; i < 4; i++) {
+    report[i] = (uint8_t)(pressed >> (8 * i));
+    report[4 + i] = (uint8_t)(timeUs >> (8 * i));
+  }
+  queued = true;
+  poll();
+}
+
+void HidReport::poll() {
+  if (!queued) return;
+  CoreMutex m(&__usb_mutex);
+  // the core adds a report ID (and findHIDReportID() returns it) once several HID devices exist
+  if (!tud_mounted() || !USB.HIDReady()) return;
+  if (tud_hid_report(USB.findHIDReportID(deviceId), report, sizeof(report))) {
+    queued = false;
+    sentUs = micros();
+  }
+}
+
+// Unmounted or unread: the report stays parked instead of waking the loop every 1 ms; the next
+// send() or any later poll() delivers it, and every connect sends a fresh one.
+bool HidReport::pending() {
+  if (!queued || !tud_mounted()) return false;
+  return micros() - sentUs < RETRY_US;
+}
+
+#else
+
+void HidReport::begin() {}
+void HidReport::send(uint32_t, uint32_t) {}
+void HidReport::poll() {}
+bool HidReport::pending() { return false; }
+
+#endif
@@ -0,0 +1,22 @@
+#pragma once
+#include <Arduino.h>
+
+// 1 = add a vendor HID interface next to CDC (composite device) that carries the debounced
+// button bitmap as an 8-byte input report, polled every 1 ms. The host reads it from hidraw
+// without any parsing; CDC keeps the commands, CONFIG and the held/repeat/chord events.
+#ifndef HOTKEY_HID
+  #define HOTKEY_HID 0
+#endif
+
+class HidReport {
+public:
+  static constexpr bool enabled() { return HOTKEY_HID != 0; }
+
+  static void begin(); // before usbSerial.begin(): registering re-enumerates the device
+
+  // queue the current bitmap; a report the host has not polled yet is replaced, so the
+  // endpoint always carries the newest state
+  static void send(uint32_t pressed, uint32_t timeUs);
+  static void poll();          // retry a report the endpoint was too busy for
+  static bool pending();       // worth a retry soon; false while unmounted or nobody reads
+};
@@ -0,0 +1,19 @@
+#include "idle.h"
+
+#if defined(ARDUINO_ARCH_RP2040)
+  #include "pico/time.h"
+#endif
+
+void Idle::sleep() const {
+  const int32_t leftUs = (int32_t)(dueUs_ - Buttons::nowUs());
+  if (leftUs <= 0) return;
+
+#if defined(ARDUINO_ARCH_RP2040)
+  // WFE with an alarm as the upper bound; an IRQ taken before the WFE has already set the
+  // event flag, so an edge between the deadline check and here isn't lost
+  best_effort_wfe_or_timeout(from_us_since_boot(time_us_64() + (uint32_t)leftUs));
+#else
+  if (leftUs >= 16000) delay((uint32_t)leftUs / 1000);
+  else delayMicroseconds((uint32_t)leftUs);
+#endif
+}
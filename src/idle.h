@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+
+#include "buttons.h"
+
+// Longest sleep between two loop() passes. With edge IRQs every input wakes the core on its
+// own, so this is only a safety net; without them it is the button poll period.
+#ifndef IDLE_MAX_US
+  #if BUTTON_SCAN_IRQ
+    #define IDLE_MAX_US 1000000
+  #else
+    #define IDLE_MAX_US 10000
+  #endif
+#endif
+
+// Collects the earliest deadline of everything that wants the loop to run, then sleeps
+// until then. Any interrupt (button edge, USB, timer) ends the sleep early.
+class Idle {
+public:
+  Idle(uint32_t nowUs, uint32_t maxUs) : nowUs_(nowUs), dueUs_(nowUs + maxUs) {}
+
+  void at(uint32_t dueUs) {
+    if ((int32_t)(dueUs - dueUs_) < 0) dueUs_ = dueUs;
+  }
+  void now() { dueUs_ = nowUs_; }
+
+  uint32_t dueUs() const { return dueUs_; }
+  void sleep() const; // returns at once if already due
+
+private:
+  uint32_t nowUs_;
+  uint32_t dueUs_;
+};
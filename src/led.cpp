@@ -5,59 +5,473 @@
 #include "led.h"
 
 #include "FastLED.h"
+#include "board.h"
+#include "pixel.h"
+#include "ring.h"
+#include "stats.h"
 #include "usbserial.h"
 
-#ifndef LED_PIN
-  #define LED_PIN 29
+#if defined(ARDUINO_ARCH_RP2040)
+  #include "hardware/sync.h"
 #endif
 
-#ifndef LEDS_PER_BUTTON
-  #define LEDS_PER_BUTTON 2
+#if LED_PIO
+  #if !defined(ARDUINO_ARCH_RP2040)
+    #error "LED_PIO needs an RP2040"
+  #endif
+  #include "ws2812_pio.h"
+static_assert(Board::numLeds <= Ws2812Pio::MAX_LEDS, "LED_PIO frame buffer too small");
 #endif
 
-#ifndef BRIGHTNESS
-  #define BRIGHTNESS 64
+#define LED_TYPE WS2812B
+#define COLOR_ORDER GRB
+
+CRGB leds[Board::numLeds];
+
+// LED_PIO builds fall back to FastLED when no PIO state machine, DMA channel or spin lock is free
+static bool pioDriver = false;
+
+static constexpr uint32_t LED_FRAME_US = LED_FRAME_HZ ? 1000000u / (LED_FRAME_HZ ? LED_FRAME_HZ : 1) : 0;
+
+// effects keep animating even when LED_FRAME_HZ=0
+static constexpr uint32_t EFFECT_FRAME_US = 1000000u / (LED_FRAME_HZ ? LED_FRAME_HZ : 60);
+
+static bool frameDirty = false;
+static uint32_t lastShowUs = 0;
+
+// STAGE ... COMMIT: no show while held, the staged frame goes out on release
+static bool holding = false;
+static uint32_t holdUntilUs = 0;
+
+// --- frame buffer; only ever touched by the core that owns the LEDs ---
+
+static uint32_t baseColor[Board::buttons];
+static LedEffectSpec effects[Board::buttons];
+static uint32_t effectStartMs[Board::buttons];
+static uint32_t effectMask = 0; // bit i = button i runs an effect
+static bool effectPending = false; // some effect changes again at effectDueUs
+static uint32_t effectDueUs = 0;
+
+static constexpr uint32_t NEVER_MS = UINT32_MAX;
+
+static uint8_t globalBrightness = BRIGHTNESS;
+static uint8_t buttonScale[Board::buttons];  // per-button level, 255 = full
+static uint8_t buttonLevel[Board::buttons];  // buttonScale * globalBrightness
+
+// 0xRRGGBB -> value for leds[], see Pixel::shade()
+static CRGB toLed(uint8_t buttonIndex, uint32_t color)
+{
+  const Rgb c = Pixel::shade(color, buttonLevel[buttonIndex], LED_GAMMA);
+  return CRGB(c.r, c.g, c.b);
+}
+
+// buttonIndex < Board::buttons, checked by the callers; the block size is a constant.
+// Returns true if any LED of the button changed.
+static bool writeButton(uint8_t buttonIndex, uint32_t color)
+{
+  return Board::fillButton(leds, buttonIndex, toLed(buttonIndex, color));
+}
+
+static void fillButton(uint8_t buttonIndex, uint32_t color)
+{
+  if (buttonIndex >= Board::buttons) return;
+  baseColor[buttonIndex] = color;
+  if (!(effectMask & (1u << buttonIndex))) writeButton(buttonIndex, color);
+}
+
+static void fillAll(uint32_t color)
+{
+  for (uint32_t& c : baseColor) c = color;
+  effectMask = 0;
+  for (uint8_t b = 0; b < Board::buttons; b++) writeButton(b, color);
+}
+
+// 8-bit fixed point blend: level 0 -> a, 255 -> b
+static uint32_t mix(uint32_t a, uint32_t b, uint8_t level)
+{
+  const uint32_t w = level + (level >> 7); // 0..256
+  uint32_t out = 0;
+  for (uint8_t shift = 0; shift <= 16; shift += 8) {
+    const uint32_t ca = (a >> shift) & 0xFF;
+    const uint32_t cb = (b >> shift) & 0xFF;
+    out |= (((ca * (256 - w) + cb * w) >> 8) & 0xFF) << shift;
+  }
+  return out;
+}
+
+// Returns true if the button's LEDs changed. waitMs is lowered to the time until its output
+// can change again: 0 = next frame, NEVER_MS = not until a command changes it.
+static bool renderEffect(uint8_t b, uint32_t nowMs, uint32_t& waitMs)
+{
+  const LedEffectSpec& fx = effects[b];
+  const uint32_t elapsed = nowMs - effectStartMs[b];
+
+  if (fx.durationMs) {
+    if (elapsed >= fx.durationMs) {
+      effectMask &= ~(1u << b);
+      return writeButton(b, baseColor[b]);
+    }
+    const uint32_t left = fx.durationMs - elapsed;
+    if (left < waitMs) waitMs = left;
+  }
+
+  const uint32_t period = fx.periodMs ? fx.periodMs : 1;
+  const uint32_t t = (elapsed + fx.phaseMs) % period;
+  const uint8_t pos = (uint8_t)((t << 8) / period);
+
+  switch (fx.mode) {
+    case LedEffect::Solid:
+      return writeButton(b, fx.color);
+    case LedEffect::Blink: {
+      const uint32_t half = (period + 1) / 2; // pos < 128 exactly while t < half
+      const uint32_t flip = t < half ? half - t : period - t;
+      if (flip < waitMs) waitMs = flip;
+      return writeButton(b, pos < 128 ? fx.color : fx.color2);
+    }
+    case LedEffect::Pulse:
+      waitMs = 0;
+      return writeButton(b, mix(fx.color2, fx.color, triwave8(pos)));
+    case LedEffect::Breathe:
+      waitMs = 0;
+      return writeButton(b, mix(fx.color2, fx.color, cubicwave8(pos)));
+    case LedEffect::Chase: {
+      waitMs = 0;
+      const uint8_t lit = (uint8_t)(((uint16_t)pos * Board::ledsPerButton) >> 8);
+      CRGB* out = leds + Board::firstLed(b);
+      bool changed = false;
+      for (uint8_t i = 0; i < Board::ledsPerButton; i++) {
+        const CRGB c = toLed(b, i == lit ? fx.color : fx.color2);
+        changed |= out[i] != c;
+        out[i] = c;
+      }
+      return changed;
+    }
+    case LedEffect::None:
+      break;
+  }
+  return false;
+}
+
+// renders every effect and schedules the next pass; true if any LED changed
+static bool renderEffects(uint32_t nowUs)
+{
+  const uint32_t nowMs = millis();
+  uint32_t waitMs = NEVER_MS;
+  bool changed = false;
+  for (uint32_t m = effectMask; m; m &= m - 1) {
+    changed |= renderEffect((uint8_t)__builtin_ctz(m), nowMs, waitMs);
+  }
+  effectPending = waitMs != NEVER_MS;
+  if (effectPending) effectDueUs = nowUs + (waitMs ? waitMs * 1000u : EFFECT_FRAME_US);
+  return changed;
+}
+
+static void applyEffect(uint8_t b, const LedEffectSpec& fx)
+{
+  if (b >= Board::buttons) return;
+
+  if (fx.mode == LedEffect::None) {
+    effectMask &= ~(1u << b);
+    writeButton(b, baseColor[b]);
+    return;
+  }
+
+  effects[b] = fx;
+  effectStartMs[b] = millis();
+  effectMask |= 1u << b;
+  renderEffects(micros());
+}
+
+// rescale everything from the base colors; shown with the next frame
+static void applyBrightness(uint8_t button, uint8_t level)
+{
+  if (button < Board::buttons) buttonScale[button] = level;
+  else globalBrightness = level;
+
+  for (uint8_t b = 0; b < Board::buttons; b++) {
+    buttonLevel[b] = Pixel::scaleVideo(buttonScale[b], globalBrightness);
+    if (!(effectMask & (1u << b))) writeButton(b, baseColor[b]);
+  }
+  renderEffects(micros());
+  frameDirty = true;
+}
+
+static void showNow()
+{
+  if (!frameDirty || holding) return;
+  frameDirty = false;
+  STATS_START(showStartUs);
+#if LED_PIO
+  if (pioDriver) Ws2812Pio::show(leds); // packs and returns, DMA does the rest
+  else FastLED.show();
+#else
+  FastLED.show();
 #endif
+  STATS_SINCE(LedShow, showStartUs);
+}
 
-#ifndef HOTKEY_BUTTONS
-  #define HOTKEY_BUTTONS 12
+static void markDirty()
+{
+  frameDirty = true;
+#if LED_FRAME_HZ == 0
+  showNow();
 #endif
+}
 
-#define LED_TYPE WS2812B
-#define COLOR_ORDER GRB
-#define NUM_LEDS HOTKEY_BUTTONS * LEDS_PER_BUTTON
+static void holdFrames(uint32_t timeoutUs)
+{
+  holding = true;
+  holdUntilUs = micros() + timeoutUs;
+}
+
+static void releaseFrames()
+{
+  if (!holding) return;
+  holding = false;
+  lastShowUs = micros(); // out right away, not paced
+  showNow();
+}
+
+static void frameTick(uint32_t nowUs)
+{
+  if (holding && (int32_t)(nowUs - holdUntilUs) >= 0) holding = false; // COMMIT never came
+
+  // only effects that can have moved are rendered, and only a change costs a show
+  if (effectMask && effectPending && (int32_t)(nowUs - effectDueUs) >= 0) {
+    if (renderEffects(nowUs)) frameDirty = true;
+  }
+
+  if (!frameDirty || holding) return;
+  if ((nowUs - lastShowUs) < LED_FRAME_US) return;
+
+  lastShowUs = nowUs;
+  showNow();
+}
+
+static bool frameDue(uint32_t& dueUs)
+{
+  bool any = false;
+  if (effectMask && effectPending) { // a solid effect never needs a wake-up
+    dueUs = effectDueUs;
+    any = true;
+  }
+  if (holding) {
+    if (!any || (int32_t)(holdUntilUs - dueUs) < 0) dueUs = holdUntilUs;
+    any = true;
+  } else if (frameDirty) {
+    const uint32_t showUs = lastShowUs + LED_FRAME_US;
+    if (!any || (int32_t)(showUs - dueUs) < 0) dueUs = showUs;
+    any = true;
+  }
+  return any;
+}
 
-CRGB leds[NUM_LEDS];
+#if LED_CORE1
+
+// core 0 -> core 1 command queue
+enum class LedOpKind : uint8_t { Set, SetAll, Brightness, Flush, Effect, Hold, Release };
+
+struct LedOp {
+  LedOpKind kind;
+  uint8_t button; // 0xFF = all (brightness)
+  bool more;      // part of a batch that continues with the next op
+  uint32_t value; // color or brightness
+  LedEffectSpec fx;
+};
+
+static SpscRing<LedOp, LED_QUEUE_SIZE> ledOps;
+static uint32_t opsPosted = 0;         // core 0 only
+static volatile uint32_t opsDone = 0;  // core 1 only
+
+static void post(LedOpKind kind, uint8_t button, uint32_t value, bool more = false,
+                 const LedEffectSpec& fx = LedEffectSpec{})
+{
+  // the LED core drains this within one frame; waiting beats losing a color
+  while (!ledOps.push(LedOp{kind, button, more, value, fx})) {
+  }
+  opsPosted++;
+#if defined(ARDUINO_ARCH_RP2040)
+  __sev(); // core 1 may be sleeping until its next frame
+#endif
+}
+
+void Led::service()
+{
+  LedOp op;
+  bool midBatch = false;
+  while (ledOps.pop(op)) {
+    switch (op.kind) {
+      case LedOpKind::Set:        fillButton(op.button, op.value); break;
+      case LedOpKind::SetAll:     fillAll(op.value); break;
+      case LedOpKind::Effect:     applyEffect(op.button, op.fx); break;
+      case LedOpKind::Brightness: applyBrightness(op.button, (uint8_t)op.value); break;
+      case LedOpKind::Flush:      showNow(); break;
+      case LedOpKind::Hold:       holdFrames(op.value); break;
+      case LedOpKind::Release:    releaseFrames(); break;
+    }
+    midBatch = op.more;
+    if (!midBatch && (op.kind == LedOpKind::Set || op.kind == LedOpKind::SetAll || op.kind == LedOpKind::Effect)) {
+      markDirty();
+    }
+    opsDone = opsDone + 1;
+  }
+
+  // never show half a batch
+  if (!midBatch) frameTick(micros());
+}
+
+#endif
 
 void Led::init()
 {
-  CFastLED::addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS)
-    .setCorrection(TypicalLEDStrip);
-  FastLED.setBrightness(BRIGHTNESS);
-  setAllLed(CRGB::Yellow);
+#if LED_PIO
+  pioDriver = Ws2812Pio::init(Board::ledPin, Board::numLeds); // GRB + Pixel::CORRECTION, like below
+#endif
+  if (!pioDriver) {
+    CFastLED::addLeds<LED_TYPE, Board::ledPin, COLOR_ORDER>(leds, Board::numLeds)
+      .setCorrection(CRGB(Pixel::CORRECTION));
+    FastLED.setBrightness(255); // scaled per button in toLed()
+  }
+  for (uint8_t& s : buttonScale) s = 255;
+  applyBrightness(0xFF, BRIGHTNESS);
+  fillAll(CRGB::Yellow);
+  // no show here: the first tick sends yellow, or the saved scene setup() applies on top
+  frameDirty = true;
 }
 
-void Led::setBrightness(fl::u8 brightness)
+const char* Led::driver()
 {
-  FastLED.setBrightness(brightness);
-  FastLED.show();
+  return pioDriver ? "pio" : "fastled";
+}
+
+void Led::setBrightness(uint8_t brightness)
+{
+#if LED_CORE1
+  post(LedOpKind::Brightness, 0xFF, brightness);
+#else
+  applyBrightness(0xFF, brightness);
+#endif
+}
+
+void Led::setButtonBrightness(uint8_t buttonIndex, uint8_t level)
+{
+  if (buttonIndex >= Board::buttons) return;
+#if LED_CORE1
+  post(LedOpKind::Brightness, buttonIndex, level);
+#else
+  applyBrightness(buttonIndex, level);
+#endif
 }
 
 void Led::setLed(uint8_t buttonIndex, uint32_t color)
 {
-  const uint16_t base = (uint16_t)buttonIndex * (uint16_t)LEDS_PER_BUTTON;
-  if (base >= NUM_LEDS) return;
+#if LED_CORE1
+  post(LedOpKind::Set, buttonIndex, color);
+#else
+  fillButton(buttonIndex, color);
+  markDirty();
+#endif
+}
 
-  for (uint8_t i = 0; i < LEDS_PER_BUTTON; i++) {
-    const uint16_t ledIndex = base + i;
-    if (ledIndex < NUM_LEDS) leds[ledIndex] = (CRGB)color;
+void Led::setLeds(const uint8_t* buttons, const uint32_t* colors, uint8_t count)
+{
+  for (uint8_t i = 0; i < count; i++) {
+#if LED_CORE1
+    post(LedOpKind::Set, buttons ? buttons[i] : i, colors[i], i + 1 < count);
+#else
+    fillButton(buttons ? buttons[i] : i, colors[i]);
+#endif
   }
-
-  FastLED.show();
+#if !LED_CORE1
+  markDirty();
+#endif
 }
 
 void Led::setAllLed(uint32_t color)
 {
-  fill_solid(leds, NUM_LEDS, color);
-  FastLED.show();
+#if LED_CORE1
+  post(LedOpKind::SetAll, 0, color);
+#else
+  fillAll(color);
+  markDirty();
+#endif
+}
+
+void Led::setEffect(uint8_t button, const LedEffectSpec& fx)
+{
+#if LED_CORE1
+  post(LedOpKind::Effect, button, 0, false, fx);
+#else
+  applyEffect(button, fx);
+  markDirty();
+#endif
+}
+
+void Led::tick(uint32_t nowUs)
+{
+#if LED_CORE1
+  (void)nowUs; // frames are paced by Led::service() on core 1
+#else
+  frameTick(nowUs);
+#endif
+}
+
+void Led::flush()
+{
+#if LED_CORE1
+  post(LedOpKind::Flush, 0, 0);
+#else
+  showNow();
+#endif
+}
+
+void Led::hold(uint32_t timeoutUs)
+{
+#if LED_CORE1
+  post(LedOpKind::Hold, 0, timeoutUs);
+#else
+  holdFrames(timeoutUs);
+#endif
+}
+
+void Led::release()
+{
+#if LED_CORE1
+  post(LedOpKind::Release, 0, 0);
+#else
+  releaseFrames();
+#endif
+}
+
+bool Led::dirty()
+{
+  return frameDirty;
+}
+
+uint32_t Led::baseColor(uint8_t buttonIndex)
+{
+  return buttonIndex < Board::buttons ? ::baseColor[buttonIndex] : 0;
+}
+
+uint8_t Led::brightness()
+{
+  return globalBrightness;
+}
+
+uint8_t Led::buttonBrightness(uint8_t buttonIndex)
+{
+  return buttonIndex < Board::buttons ? buttonScale[buttonIndex] : 0;
+}
+
+void Led::sync()
+{
+#if LED_CORE1
+  while (opsDone != opsPosted) {
+  }
+#endif
+}
+
+bool Led::nextDue(uint32_t& dueUs)
+{
+  return frameDue(dueUs);
 }
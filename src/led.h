@@ -3,13 +3,90 @@
 //
 
 #pragma once
+#include <cstdint>
 
-#include "FastLED.h"
+// The LED interface, free of FastLED so the command handlers (commands.cpp) and the native
+// bench build against it; led.cpp drives the strip, bench/stubs.cpp stands in on the host.
+
+// global brightness at power-on and after a connect without a saved scene
+#ifndef BRIGHTNESS
+  #define BRIGHTNESS 64
+#endif
+
+// Max frame rate for coalesced updates, 0 = show on every command
+#ifndef LED_FRAME_HZ
+  #define LED_FRAME_HZ 60
+#endif
+
+// 1 = the LEDs are driven from core 1 (setup1/loop1); core 0 only queues commands,
+// so FastLED.show() never stalls button scanning or USB.
+#ifndef LED_CORE1
+  #define LED_CORE1 0
+#endif
+
+// 1 = RP2040 PIO + DMA driver instead of FastLED's clockless one: show() packs the frame
+// and returns, the transfer runs in the background (see ws2812_pio.h).
+#ifndef LED_PIO
+  #define LED_PIO 0
+#endif
+
+// 1 = colors go through a gamma 2.5 table so dim values and mixes look right. Off by default:
+// mid-range colors come out much darker with it, so configs written without it need retuning.
+#ifndef LED_GAMMA
+  #define LED_GAMMA 0
+#endif
+
+#ifndef LED_QUEUE_SIZE
+  #define LED_QUEUE_SIZE 64
+#endif
+
+// On-device effects, rendered every frame on top of the button's base color.
+// SET_SINGLE/SET_MANY only change the base underneath; SET_ALL clears all effects.
+enum class LedEffect : uint8_t { None, Solid, Blink, Pulse, Breathe, Chase };
+
+struct LedEffectSpec {
+  LedEffect mode = LedEffect::None;
+  uint32_t color = 0;       // primary color
+  uint32_t color2 = 0;      // off / low color
+  uint16_t periodMs = 1000; // one full cycle
+  uint16_t phaseMs = 0;     // offset into the cycle, lines up several buttons
+  uint16_t durationMs = 0;  // 0 = until replaced, else revert to the base color
+};
 
 class Led{
 public:
   static void init();
-  static void setBrightness(fl::u8 brightness);
+  static const char* driver(); // "pio", or "fastled" (also when LED_PIO found no free PIO/DMA)
+  // Brightness is folded into the colors when they are written and is picked up by the
+  // next frame, it never forces a show on its own.
+  static void setBrightness(uint8_t brightness);
+  static void setButtonBrightness(uint8_t button, uint8_t level); // on top of the global one
   static void setLed(uint8_t led, uint32_t color);
   static void setAllLed(uint32_t color);
+  // Several buttons in one go (buttons == nullptr -> 0..count-1), one frame update.
+  static void setLeds(const uint8_t* buttons, const uint32_t* colors, uint8_t count);
+  static void setEffect(uint8_t button, const LedEffectSpec& fx);
+
+  // Current settings, for saving a scene. With LED_CORE1 these read the LED core's state
+  // directly; a value changing at the same time reads as either the old or the new one.
+  static uint32_t baseColor(uint8_t button);
+  static uint8_t brightness();
+  static uint8_t buttonBrightness(uint8_t button);
+
+  // Commands only touch the frame buffer; tick() pushes it out at most once per frame period.
+  static void tick(uint32_t nowUs);
+  static void flush(); // show now if anything changed
+
+  // STAGE/COMMIT: keep every change off the LEDs until release(), which shows them in one
+  // frame so several panels can switch together. A hold nobody releases ends after timeoutUs.
+  static void hold(uint32_t timeoutUs);
+  static void release();
+
+  static bool dirty();
+  static void sync(); // returns once every command so far is applied (LED_CORE1: on core 1)
+  static bool nextDue(uint32_t& dueUs); // next effect frame / paced show, on the LED core
+
+#if LED_CORE1
+  static void service(); // core 1: apply queued commands, pace frames
+#endif
 };
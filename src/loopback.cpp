@@ -0,0 +1,40 @@
+#include "loopback.h"
+
+#if LOOPBACK_PIN >= 0
+
+static bool active = false;
+static uint32_t releaseUs = 0;
+
+void Loopback::init() {
+  pinMode(LOOPBACK_PIN, INPUT); // idle: high-Z, the button input's pull-up wins
+}
+
+bool Loopback::trigger(uint16_t ms, uint32_t nowUs) {
+  if (active) return false;
+  digitalWrite(LOOPBACK_PIN, LOW);
+  pinMode(LOOPBACK_PIN, OUTPUT);
+  active = true;
+  releaseUs = nowUs + (uint32_t)ms * 1000u;
+  return true;
+}
+
+void Loopback::poll(uint32_t nowUs) {
+  if (!active || (int32_t)(nowUs - releaseUs) < 0) return;
+  pinMode(LOOPBACK_PIN, INPUT);
+  active = false;
+}
+
+bool Loopback::nextDue(uint32_t& dueUs) {
+  if (!active) return false;
+  dueUs = releaseUs;
+  return true;
+}
+
+#else
+
+void Loopback::init() {}
+bool Loopback::trigger(uint16_t, uint32_t) { return false; }
+void Loopback::poll(uint32_t) {}
+bool Loopback::nextDue(uint32_t&) { return false; }
+
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+#include <Arduino.h>
+
+// Benchmark aid: TRIGGER pulls this pin low for a while. Wire it to a button input and the
+// resulting press event measures scan + debounce + report latency end to end. -1 = disabled.
+#ifndef LOOPBACK_PIN
+  #define LOOPBACK_PIN -1
+#endif
+
+class Loopback {
+public:
+  static constexpr bool enabled() { return LOOPBACK_PIN >= 0; }
+
+  static void init();
+  static bool trigger(uint16_t ms, uint32_t nowUs); // false if disabled or still active
+  static void poll(uint32_t nowUs);                 // release the pin when the pulse is over
+  static bool nextDue(uint32_t& dueUs);             // end of the running pulse
+};
@@ -1,232 +1,255 @@
 #include <Arduino.h>
 #include <cstring>
-#include <strings.h>
 
-#include "bootloader.h"
+#include "board.h"
+#include "buttons.h"
+#include "chords.h"
+#include "commands.h"
+#include "debounce.h"
+#include "device.h"
+#include "eventlog.h"
+#include "events.h"
+#include "frame.h"
+#include "hidreport.h"
+#include "idle.h"
 #include "led.h"
+#include "loopback.h"
+#include "scene.h"
+#include "stats.h"
 #include "usbserial.h"
 
-#ifndef HOTKEY_BUTTON_PINS_MAP
-  #error "Define HOTKEY_BUTTON_PINS_MAP in platformio.ini, e.g. -DHOTKEY_BUTTON_PINS_MAP=2,3,4,..."
-#endif
-
-#ifndef BRIGHTNESS
-  #define BRIGHTNESS 64
-#endif
-
-#ifndef HOTKEY_BUTTONS
-  #define HOTKEY_BUTTONS 12
-#endif
-
-inline constexpr uint8_t HOTKEY_BUTTON_PINS[] = { HOTKEY_BUTTON_PINS_MAP };
-
 Led led;
 extern UsbSerial usbSerial;
-Bootloader bootloader;
+Buttons buttons;
 
-static constexpr uint32_t DEBOUNCE_MS = 20;
-static bool stablePressed[HOTKEY_BUTTONS]{};
-static bool lastRaw[HOTKEY_BUTTONS]{};
-static uint32_t lastChange[HOTKEY_BUTTONS]{};
+#define FIRMWARE_VERSION "0.0.1"
+static constexpr uint8_t READY_VERSION = 1; // layout of the READY line
 
-#define STR_HELPER(x) #x
-#define STR(x) STR_HELPER(x)
+static constexpr uint32_t USB_TX_RETRY_US = 1000; // one USB frame
 
-#define STRVA_HELPER(...) #__VA_ARGS__
-#define STRVA(...) STRVA_HELPER(__VA_ARGS__)
+using ButtonDebouncer = Debouncer<DefaultDebounce, DEBOUNCE_US, DEBOUNCE_TICK_US, Board::buttonMask>;
+static ButtonDebouncer debouncer; // bit i = button i
+static ButtonEvents buttonEvents;
+static Chords chords;
+static uint32_t shownPressed = 0; // as the host sees it: debounced, chord buttons held back
 
-static void printConfig()
+static void replyFrame(uint8_t seq, CmdResult r)
 {
-  UsbSerial::println("=== CONFIG ===");
-  
-  // Core settings
-  UsbSerial::printf("SERIAL_BAUDRATE=%s\n", STR(SERIAL_BAUDRATE));
-  UsbSerial::printf("BRIGHTNESS=%s\n", STR(BRIGHTNESS));
-  UsbSerial::printf("HOTKEY_BUTTONS=%s\n", STR(HOTKEY_BUTTONS));
-
-  // Boot key
-#if BOOT_KEY_PIN >= 0
-  UsbSerial::printf("BOOT_KEY_PIN=%s\n", STR(BOOT_KEY_PIN));
-#else
-  usbSerial.println("BOOT_KEY_PIN=<disabled>");
-#endif
-  UsbSerial::printf("BOOT_KEY_ACTIVE_LOW=%s\n", STR(BOOT_KEY_ACTIVE_LOW));
-  UsbSerial::printf("BOOT_DBL_MS=%s\n", STR(BOOT_DBL_MS));
-
-  // LED-related (only if defined)
-#ifdef LED_PIN
-  UsbSerial::printf("LED_PIN=%s\n", STR(LED_PIN));
-#else
-  usbSerial.println("LED_PIN=<not defined>");
-#endif
-
-#ifdef LEDS_PER_BUTTON
-  UsbSerial::printf("LEDS_PER_BUTTON=%s\n", STR(LEDS_PER_BUTTON));
-#else
-  usbSerial.println("LEDS_PER_BUTTON=<not defined>");
-#endif
+  const FrameStatus st = (r == CmdResult::Ok)  ? FrameStatus::Ok
+                       : (r == CmdResult::Err) ? FrameStatus::Err
+                                               : FrameStatus::Unknown;
+  const uint8_t ack[] = { (uint8_t)FrameOp::Ack, seq, (uint8_t)st };
+  UsbSerial::writeFrame(ack, sizeof(ack));
+}
 
-  // Button pin map (macro text + resolved values)
-  UsbSerial::printf("HOTKEY_BUTTON_PINS_MAP=%s\n", STRVA(HOTKEY_BUTTON_PINS_MAP));
+static_assert((uint8_t)FrameOp::Repeat - (uint8_t)FrameOp::Pressed == (uint8_t)ButtonEvent::Repeat,
+              "event frame ops follow the ButtonEvent order");
 
-  UsbSerial::println("HOTKEY_BUTTON_PINS=[");
-  for (uint8_t i = 0; i < HOTKEY_BUTTONS; i++) {
-    UsbSerial::printf("%u", (unsigned)HOTKEY_BUTTON_PINS[i]);
-    if (i + 1 < HOTKEY_BUTTONS) UsbSerial::println(",");
+static void reportEvent(ButtonEvent ev, uint8_t button, uint32_t timeUs)
+{
+  if (!Commands::reportEvents()) return;
+  STATS_COUNT(Events, 1);
+  if (ev == ButtonEvent::Pressed || ev == ButtonEvent::Released) {
+    STATS_RECORD(ScanToReport, Buttons::nowUs() - timeUs);
   }
-  UsbSerial::println("]");
-}
 
-static bool parseKeyVal(const char* tok, const char* key, const char** valOut) {
-  size_t klen = strlen(key);
-  if (strncasecmp(tok, key, klen) != 0) return false;
-  if (tok[klen] != '=') return false;
-  *valOut = tok + klen + 1;
-  return true;
+  // logged even while USB is down, EVENTS SINCE=<seq> gets it back
+  Commands::sendEvent(EventLog::append((uint8_t)FrameOp::Pressed + (uint8_t)ev, button, timeUs));
 }
 
-static bool parseU8Dec(const char* s, uint8_t* out) {
-  if (!s || !*s) return false;
-  char* end = nullptr;
-  long v = strtol(s, &end, 10);
-  if (!end || *end != '\0') return false;
-  if (v < 0 || v > 255) return false;
-  *out = (uint8_t)v;
-  return true;
+static void reportStateSnapshot(uint32_t pressed, uint32_t timeUs)
+{
+  STATS_COUNT(Events, 1);
+  STATS_RECORD(ScanToReport, Buttons::nowUs() - timeUs);
+  if (usbSerial.framed()) {
+    uint8_t msg[9] = { (uint8_t)FrameOp::State };
+    Frame::putU32le(msg + 1, pressed);
+    Frame::putU32le(msg + 5, timeUs);
+    UsbSerial::writeFrame(msg, sizeof(msg));
+  } else {
+    UsbSerial::printf("state %lx t=%lu\n", (unsigned long)pressed, (unsigned long)timeUs);
+  }
 }
 
-static bool parseColor24(const char* s, uint32_t* out) {
-  if (!s || !*s) return false;
-  if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) s += 2;
+static void onChord(uint8_t index, const Chord& chord, uint32_t timeUs)
+{
+  Commands::sendEvent(EventLog::append((uint8_t)FrameOp::Chord, index, timeUs));
 
-  char* end = nullptr;
-  unsigned long v = strtoul(s, &end, 16);
-  if (!end || *end != '\0') return false;
-  *out = (uint32_t)v & 0x00FFFFFFu;
-  return true;
+  if (chord.action == ChordAction::Bootloader) Device::rebootToBootloader();
 }
 
-
-enum class CmdResult : uint8_t { Unknown, Ok, Err };
-
-CmdResult handleCommand(char *line)
+// "[#<seq>] CMD ..." -> "[#<seq>] OK|ERR|UNKNOWN"; the tag lets the host pipeline
+static void dispatchLine(char* line)
 {
-  char *cmd = strtok(line, " \t");
-  if (!cmd) return CmdResult::Err;
-
-  if (strcasecmp(cmd, "BOOT_BOOTLOADER") == 0) {
-    if (strtok(nullptr, " \t") != nullptr) return CmdResult::Err;
-    UsbSerial::println("Rebooting to bootloader...");
-    delay(50);
-    bootloader.loadBootloader();
-    return CmdResult::Ok; // (won't return on RP2040, but fine)
-  }
+  while (*line == ' ' || *line == '\t') line++;
 
-  if (strcasecmp(cmd, "CONFIG") == 0) {
-    if (strtok(nullptr, " \t") != nullptr) return CmdResult::Err;
-    printConfig();                 // implement as discussed earlier
-    return CmdResult::Ok;
+  const char* tag = nullptr;
+  if (*line == '#') {
+    tag = line;
+    line += strcspn(line, " \t");
+    if (*line) *line++ = '\0';
   }
 
-  if (strcasecmp(cmd, "SET_SINGLE") == 0) {
-    const char* bVal = nullptr;
-    const char* cVal = nullptr;
-
-    for (char* tok = strtok(nullptr, " \t"); tok; tok = strtok(nullptr, " \t")) {
-      const char* v = nullptr;
-      if (parseKeyVal(tok, "B", &v)) { bVal = v; continue; }
-      if (parseKeyVal(tok, "C", &v)) { cVal = v; continue; }
-      return CmdResult::Err; // unknown token
-    }
-
-    uint8_t id;
-    uint32_t color;
-    if (!bVal || !cVal) return CmdResult::Err;
-    if (!parseU8Dec(bVal, &id)) return CmdResult::Err;
-    if (!parseColor24(cVal, &color)) return CmdResult::Err;
-
-    Led::setLed(id, color);      // button index -> lights LEDS_PER_BUTTON block
-    return CmdResult::Ok;
-  }
+  STATS_START(cmdStartUs);
+  const CmdResult r = Commands::handleLine(line);
+  STATS_SINCE(Command, cmdStartUs);
+  STATS_COUNT(Commands, 1);
+  const char* word = (r == CmdResult::Ok) ? "OK" : (r == CmdResult::Err) ? "ERR" : "UNKNOWN";
 
-  // --- SET_ALL C=<hex> ---
-  if (strcasecmp(cmd, "SET_ALL") == 0) {
-    const char* cVal = nullptr;
-
-    for (char* tok = strtok(nullptr, " \t"); tok; tok = strtok(nullptr, " \t")) {
-      const char* v = nullptr;
-      if (parseKeyVal(tok, "C", &v)) { cVal = v; continue; }
-      return CmdResult::Err;
-    }
-
-    uint32_t color;
-    if (!cVal) return CmdResult::Err;
-    if (!parseColor24(cVal, &color)) return CmdResult::Err;
-
-    Led::setAllLed(color);
-    return CmdResult::Ok;
-  }
+  if (tag) UsbSerial::printf("%s %s\n", tag, word);
+  else UsbSerial::println(word);
+}
 
-  return CmdResult::Unknown;
+// "READY v=<layout> fw=<version> caps=<a,b,..> buttons=<n> hash=<crc>": the host compares hash
+// (SceneStore::crc() of what the LEDs show) with what it wants and repaints only on a mismatch
+static void sendReady()
+{
+  Led::sync();
+  const uint32_t hash = SceneStore::crc(SceneStore::capture());
+  UsbSerial::printf("READY v=%u fw=%s caps=text,bin,scene,events,stage%s%s buttons=%u hash=%08lx\n",
+                    (unsigned)READY_VERSION, FIRMWARE_VERSION, HidReport::enabled() ? ",hid" : "",
+                    HOTKEY_STATS ? ",stats" : "", (unsigned)Board::buttons, (unsigned long)hash);
 }
 
 void onConnect()
 {
-  UsbSerial::println("Hotkey Companion Firmware V0.0.1");
-  Led::setAllLed(CRGB::Black);
-  Led::setBrightness(BRIGHTNESS);
+  UsbSerial::println("Hotkey Companion Firmware V" FIRMWARE_VERSION);
+  EventLog::resetHighWater();
+  Commands::onConnect();
+
+  HidReport::send(shownPressed, Buttons::nowUs()); // starting point for the host's diff
+  sendReady();
 }
 
 void setup() {
-  bootloader.init();
+  HidReport::begin();
+#if !LED_CORE1
   Led::init();
+#endif
+  buttons.init();
+  Loopback::init();
 
-  for (unsigned char i : HOTKEY_BUTTON_PINS)
-  {
-    pinMode(i, INPUT_PULLUP);
-  }
+  // the panel comes up in its saved state before the host even connects
+  SceneStore::begin();
+  Commands::begin();
+
+  debouncer.reset(0, Buttons::nowUs());
 
   usbSerial.onConnect(onConnect);
   usbSerial.begin();
 }
 
+static void showButtons(uint32_t pressed, uint32_t now)
+{
+  const uint32_t changed = pressed ^ shownPressed;
+  if (!changed) return;
+  shownPressed = pressed;
+
+  HidReport::send(pressed, now);
+  buttonEvents.update(changed, pressed, now, reportEvent);
+  if (Commands::reportState()) reportStateSnapshot(pressed, now);
+}
+
+static void scanButtons(uint32_t pressedMask, uint32_t now)
+{
+  // only buttons that changed cost anything here
+  const uint32_t changed = debouncer.update(pressedMask, now);
+  if (!changed) return;
+
+  const uint32_t pressed = debouncer.pressed();
+  const uint32_t tapped = chords.update(pressed, now);
+  if (tapped) showButtons(chords.visible(pressed) | tapped, now); // its press, then its release
+  showButtons(chords.visible(pressed), now);
+}
+
+// Sleeps until the earliest deadline of anything that needs a pass; button edges, USB and
+// the LED core's wake-ups end the sleep early.
+static void waitForWork()
+{
+  const uint32_t nowUs = Buttons::nowUs();
+  Idle idle(nowUs, IDLE_MAX_US);
+  uint32_t dueUs;
+
+  if (buttons.pending() || UsbSerial::rxPending()) idle.now();
+  if (UsbSerial::txPending()) idle.at(nowUs + USB_TX_RETRY_US); // endpoint was full
+  if (HidReport::pending()) idle.at(nowUs + USB_TX_RETRY_US);
+  if (debouncer.nextDue(dueUs)) idle.at(dueUs);
+  if (buttonEvents.nextDue(dueUs)) idle.at(dueUs);
+  if (chords.nextDue(dueUs)) idle.at(dueUs);
+  if (Loopback::nextDue(dueUs)) idle.at(dueUs);
+#if !LED_CORE1
+  if (Led::nextDue(dueUs)) idle.at(dueUs);
+#endif
+
+  STATS_START(idleStartUs);
+  idle.sleep();
+  STATS_SINCE(Idle, idleStartUs);
+}
+
 void loop() {
-  delay(10);
-  bootloader.check();
+  waitForWork();
+  STATS_START(loopStartUs);
+#if HOTKEY_STATS
+  static uint32_t lastLoopUs = loopStartUs;
+  STATS_RECORD(LoopPeriod, loopStartUs - lastLoopUs);
+  lastLoopUs = loopStartUs;
+#endif
   usbSerial.tick();
 
-  char line[128];
-  if (usbSerial.readLine(line, sizeof(line)))
-  {
-    handleCommand(line);
-  }
+  // every complete command gets exactly one reply
+  char* line = nullptr;
+  size_t lineLen = 0;
+  while (usbSerial.peekLine(&line, &lineLen)) {
+    dispatchLine(line); // parsed in place, no copy
+    usbSerial.consumeLine();
 
-  if (usbSerial.readLine(line, sizeof(line))) {
-    CmdResult r = handleCommand(line);
-    if (r == CmdResult::Ok) UsbSerial::println("OK");
-    else if (r == CmdResult::Err) UsbSerial::println("ERR");
-    else UsbSerial::println("UNKNOWN");
+    if (Commands::takeSwitchToFramed()) usbSerial.setFramed(true);
   }
 
-  uint32_t now = millis();
-
-  for (uint8_t i = 0; i < HOTKEY_BUTTONS; i++)
-  {
-    bool rawPressed = digitalRead(HOTKEY_BUTTON_PINS[i]) == LOW;
+  uint8_t frame[Frame::MAX_PAYLOAD];
+  size_t frameLen = 0;
+  while (usbSerial.framed() && usbSerial.readFrame(frame, sizeof(frame), &frameLen)) {
+    if (frameLen < 2) continue; // broken frame, counted by UsbSerial
+
+    STATS_START(cmdStartUs);
+    CmdResult r = Commands::handleFrame(frame, frameLen);
+    STATS_SINCE(Command, cmdStartUs);
+    STATS_COUNT(Commands, 1);
+    replyFrame(frame[1], r);
+    if (r == CmdResult::Ok && (FrameOp)frame[0] == FrameOp::Text) usbSerial.setFramed(false);
+  }
 
-    if (rawPressed != lastRaw[i]) {
-      lastRaw[i] = rawPressed;
-      lastChange[i] = now;
-    }
+  // edge snapshots first (in order), then the current level for debounce expiry
+  Buttons::Sample sample;
+  while (buttons.pop(sample)) {
+    scanButtons(sample.pressed, sample.timeUs);
+  }
+  scanButtons(Buttons::readPressed(), Buttons::nowUs());
+  buttonEvents.poll(Buttons::nowUs(), reportEvent);
+  chords.poll(Buttons::nowUs(), onChord);
+  showButtons(chords.visible(debouncer.pressed()), Buttons::nowUs()); // chord window ran out
+  Loopback::poll(Buttons::nowUs());
+  HidReport::poll();
+  Commands::poll(); // EVENTS replay the TX ring had no room for, and what was logged since
+
+  Led::tick(Buttons::nowUs());
+
+  // everything this pass produced goes out as one USB write
+  UsbSerial::flush();
+  STATS_SINCE(LoopBusy, loopStartUs);
+}
+#if LED_CORE1
+void setup1() {
+  Led::init();
+}
 
-    if ((now - lastChange[i]) >= DEBOUNCE_MS && rawPressed != stablePressed[i]) {
-      stablePressed[i] = rawPressed;
+void loop1() {
+  Led::service();
 
-      if (stablePressed[i])
-      {
-        //Led::setLed(i, CRGB::Yellow);
-        UsbSerial::printf("pressed %u\n", i);
-      }
-    }
-  }
-}
\ No newline at end of file
+  // post() wakes this core for new ops, otherwise sleep until the next frame
+  Idle idle(micros(), IDLE_MAX_US);
+  uint32_t dueUs;
+  if (Led::nextDue(dueUs)) idle.at(dueUs);
+  idle.sleep();
+}
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+
+// Pixel math shared by the LED drivers, free of FastLED and hardware so the native bench
+// (bench/) runs exactly what the firmware does.
+
+// --- gamma table, built at compile time ---
+
+struct GammaTable {
+  uint8_t v[256];
+};
+
+static constexpr double constSqrt(double x)
+{
+  double r = x > 1.0 ? x : 1.0;
+  for (int i = 0; i < 32; i++) r = 0.5 * (r + x / r);
+  return r;
+}
+
+static constexpr GammaTable makeGamma()
+{
+  GammaTable t{};
+  for (int i = 0; i < 256; i++) {
+    const double x = i / 255.0;
+    t.v[i] = (uint8_t)(255.0 * x * x * constSqrt(x) + 0.5); // x^2.5
+  }
+  return t;
+}
+
+static constexpr GammaTable gammaLut = makeGamma();
+static_assert(gammaLut.v[0] == 0 && gammaLut.v[255] == 255, "gamma table endpoints");
+
+// one LED as it sits in the frame buffer, layout-compatible with FastLED's CRGB
+struct Rgb {
+  uint8_t r, g, b;
+
+  friend constexpr bool operator!=(const Rgb& a, const Rgb& b) { return a.r != b.r || a.g != b.g || a.b != b.b; }
+};
+
+class Pixel {
+public:
+  // per channel scale applied on the way out, FastLED's TypicalLEDStrip; the FastLED driver
+  // is set up with CORRECTION, the PIO one packs with CORRECT_*
+  static constexpr uint32_t CORRECTION = 0xFFB0F0;
+  static constexpr uint8_t CORRECT_R = (uint8_t)(CORRECTION >> 16);
+  static constexpr uint8_t CORRECT_G = (uint8_t)(CORRECTION >> 8);
+  static constexpr uint8_t CORRECT_B = (uint8_t)CORRECTION;
+
+  // FastLED's scale8_video(): never scales a lit channel down to 0
+  static constexpr uint8_t scaleVideo(uint8_t v, uint8_t scale) {
+    return (uint8_t)((((uint16_t)v * scale) >> 8) + ((v && scale) ? 1 : 0));
+  }
+
+  // 0xRRGGBB -> frame buffer value: gamma (optional) and the button's level, folded in once
+  // when the color is written instead of on every show
+  static constexpr Rgb shade(uint32_t color, uint8_t level, bool gamma) {
+    uint8_t r = (uint8_t)(color >> 16), g = (uint8_t)(color >> 8), b = (uint8_t)color;
+    if (gamma) {
+      r = gammaLut.v[r];
+      g = gammaLut.v[g];
+      b = gammaLut.v[b];
+    }
+    return Rgb{ scaleVideo(r, level), scaleVideo(g, level), scaleVideo(b, level) };
+  }
+
+  // v * (k + 1) / 256, per channel color correction
+  static constexpr uint8_t correct(uint8_t v, uint8_t k) { return (uint8_t)(((uint16_t)v * (k + 1)) >> 8); }
+
+  // one WS2812 word: GRB, left-aligned for the 24 bit autopull
+  static constexpr uint32_t packGrb(uint8_t r, uint8_t g, uint8_t b, uint8_t kr, uint8_t kg, uint8_t kb) {
+    return ((uint32_t)correct(g, kg) << 24) | ((uint32_t)correct(r, kr) << 16) | ((uint32_t)correct(b, kb) << 8);
+  }
+
+  // frame buffer (Rgb or CRGB) -> WS2812 words, color corrected
+  template <typename Px>
+  static void packFrame(const Px* leds, uint16_t count, uint32_t* out) {
+    for (uint16_t i = 0; i < count; i++) {
+      out[i] = packGrb(leds[i].r, leds[i].g, leds[i].b, CORRECT_R, CORRECT_G, CORRECT_B);
+    }
+  }
+};
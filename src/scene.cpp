@@ -0,0 +1,60 @@
+#include "scene.h"
+
+#include <LittleFS.h>
+
+static const char* const SCENE_PATH = "/scene.bin";
+static constexpr uint32_t SCENE_MAGIC = 0x43534B48; // "HKSC"
+static constexpr uint8_t SCENE_VERSION = 1;
+
+struct SceneHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t buttons;
+  uint16_t reserved;
+  uint32_t crc; // SceneStore::crc() of the payload
+};
+
+static bool mounted = false;
+
+bool SceneStore::begin()
+{
+  mounted = LittleFS.begin();
+  return mounted;
+}
+
+bool SceneStore::load(Scene& out)
+{
+  if (!mounted) return false;
+  File f = LittleFS.open(SCENE_PATH, "r");
+  if (!f) return false;
+
+  SceneHeader h;
+  Scene s;
+  const bool read = f.read(reinterpret_cast<uint8_t*>(&h), sizeof(h)) == sizeof(h) &&
+                    f.read(reinterpret_cast<uint8_t*>(&s), sizeof(s)) == sizeof(s);
+  f.close();
+
+  if (!read || h.magic != SCENE_MAGIC || h.version != SCENE_VERSION || h.buttons != Board::buttons) return false;
+  if (h.crc != crc(s)) return false;
+  out = s;
+  return true;
+}
+
+bool SceneStore::save(const Scene& scene)
+{
+  if (!mounted) return false;
+  File f = LittleFS.open(SCENE_PATH, "w");
+  if (!f) return false;
+
+  const SceneHeader h = { SCENE_MAGIC, SCENE_VERSION, Board::buttons, 0, crc(scene) };
+  const bool ok = f.write(reinterpret_cast<const uint8_t*>(&h), sizeof(h)) == sizeof(h) &&
+                  f.write(reinterpret_cast<const uint8_t*>(&scene), sizeof(scene)) == sizeof(scene);
+  f.close();
+  return ok;
+}
+
+bool SceneStore::clear()
+{
+  if (!mounted) return false;
+  return !LittleFS.exists(SCENE_PATH) || LittleFS.remove(SCENE_PATH);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+
+#include "board.h"
+
+// LED state that survives a power cycle: base colors plus global and per-button brightness,
+// kept in LittleFS (board_build.filesystem_size) and restored in setup() and on connect.
+struct Scene {
+  uint8_t brightness;
+  uint8_t level[Board::buttons]; // per-button brightness on top of the global one
+  uint32_t color[Board::buttons]; // 0xRRGGBB
+};
+
+class SceneStore {
+public:
+  static bool begin(); // mount, formats an empty filesystem on first use
+
+  static bool load(Scene& out); // false if nothing saved, corrupt or saved for another board
+  static bool save(const Scene& scene);
+  static bool clear();
+
+  static Scene capture();               // what the LEDs are set to now
+  static void apply(const Scene& scene); // one frame, effects cleared
+
+  // zlib crc32 over brightness, then r g b level per button: the host compares it against the
+  // scene it would send to decide whether the saved one can stay
+  static uint32_t crc(const Scene& scene);
+};
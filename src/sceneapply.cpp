@@ -0,0 +1,45 @@
+#include "scene.h"
+
+#include "led.h"
+
+// The LED side of a scene, free of LittleFS (scene.cpp keeps the storage) so the native
+// bench runs it as it is.
+
+static uint32_t crc32Update(uint32_t crc, uint8_t byte)
+{
+  crc ^= byte;
+  for (uint8_t i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+  return crc;
+}
+
+uint32_t SceneStore::crc(const Scene& scene)
+{
+  uint32_t c = 0xFFFFFFFFu;
+  c = crc32Update(c, scene.brightness);
+  for (uint8_t b = 0; b < Board::buttons; b++) {
+    c = crc32Update(c, (uint8_t)(scene.color[b] >> 16));
+    c = crc32Update(c, (uint8_t)(scene.color[b] >> 8));
+    c = crc32Update(c, (uint8_t)scene.color[b]);
+    c = crc32Update(c, scene.level[b]);
+  }
+  return ~c;
+}
+
+Scene SceneStore::capture()
+{
+  Scene s;
+  s.brightness = Led::brightness();
+  for (uint8_t b = 0; b < Board::buttons; b++) {
+    s.level[b] = Led::buttonBrightness(b);
+    s.color[b] = Led::baseColor(b);
+  }
+  return s;
+}
+
+void SceneStore::apply(const Scene& scene)
+{
+  Led::setBrightness(scene.brightness);
+  for (uint8_t b = 0; b < Board::buttons; b++) Led::setButtonBrightness(b, scene.level[b]);
+  Led::setAllLed(scene.color[0]); // drops running effects
+  Led::setLeds(nullptr, scene.color, Board::buttons);
+}
@@ -0,0 +1,48 @@
+#include "stats.h"
+
+#if HOTKEY_STATS
+
+#include <cstdio>
+#include <cstring>
+
+#include "usbserial.h"
+
+Histogram Stats::hist_[(uint8_t)Stat::Count];
+uint32_t Stats::counter_[(uint8_t)Counter::Count];
+
+static const char* const HIST_NAMES[] = { "loop_us", "loop_busy_us", "idle_us", "scan_to_report_us", "led_show_us", "command_us" };
+static const char* const COUNTER_NAMES[] = { "rx_bytes", "tx_bytes", "events", "commands" };
+
+static_assert(sizeof(HIST_NAMES) / sizeof(HIST_NAMES[0]) == (size_t)Stat::Count, "one name per Stat");
+static_assert(sizeof(COUNTER_NAMES) / sizeof(COUNTER_NAMES[0]) == (size_t)Counter::Count, "one name per Counter");
+
+void Stats::print() {
+  for (uint8_t i = 0; i < (uint8_t)Stat::Count; i++) {
+    const Histogram& h = hist_[i];
+    const unsigned long avg = h.count ? (unsigned long)(h.sum / h.count) : 0;
+    UsbSerial::printf("%s n=%lu avg=%lu max=%lu\n", HIST_NAMES[i], (unsigned long)h.count, avg,
+                      (unsigned long)h.max);
+
+    // bucket i = [2^i, 2^(i+1)) us, trailing empty buckets left out
+    int last = Histogram::BUCKETS - 1;
+    while (last > 0 && h.bucket[last] == 0) last--;
+
+    char line[200];
+    size_t n = (size_t)snprintf(line, sizeof(line), "%s_log2=", HIST_NAMES[i]);
+    for (int b = 0; b <= last && n < sizeof(line); b++) {
+      n += (size_t)snprintf(line + n, sizeof(line) - n, b ? ",%lu" : "%lu", (unsigned long)h.bucket[b]);
+    }
+    UsbSerial::println(line);
+  }
+
+  for (uint8_t i = 0; i < (uint8_t)Counter::Count; i++) {
+    UsbSerial::printf("%s=%lu\n", COUNTER_NAMES[i], (unsigned long)counter_[i]);
+  }
+}
+
+void Stats::reset() {
+  memset(hist_, 0, sizeof(hist_));
+  memset(counter_, 0, sizeof(counter_));
+}
+
+#endif
@@ -0,0 +1,75 @@
+#pragma once
+#include <Arduino.h>
+
+#if defined(ARDUINO_ARCH_RP2040)
+  #include "hardware/timer.h"
+  #define STATS_CLOCK_US() time_us_32()
+#else
+  #define STATS_CLOCK_US() micros()
+#endif
+
+// 1 = hot-path timing histograms and byte counters, read with STATS / STATS RESET.
+// 0 compiles every STATS_* hook below to nothing.
+#ifndef HOTKEY_STATS
+  #define HOTKEY_STATS 0
+#endif
+
+#if HOTKEY_STATS
+
+enum class Stat : uint8_t {
+  LoopPeriod,   // loop() entry to entry
+  LoopBusy,     // loop() work after waking up
+  Idle,         // one sleep until the next wake-up
+  ScanToReport, // button sample -> event queued for USB
+  LedShow,      // FastLED.show()
+  Command,      // one command (text or frame): parse + execute
+  Count
+};
+
+enum class Counter : uint8_t { RxBytes, TxBytes, Events, Commands, Count };
+
+// log2 histogram: bucket i counts samples in [2^i, 2^(i+1)) us, bucket 0 also takes 0
+struct Histogram {
+  static constexpr uint8_t BUCKETS = 20; // up to ~1 s
+
+  uint32_t bucket[BUCKETS];
+  uint32_t count;
+  uint32_t max;
+  uint64_t sum;
+
+  void add(uint32_t us) {
+    uint8_t b = us ? (uint8_t)(31 - __builtin_clz(us)) : 0;
+    if (b >= BUCKETS) b = BUCKETS - 1;
+    bucket[b]++;
+    count++;
+    sum += us;
+    if (us > max) max = us;
+  }
+};
+
+class Stats {
+public:
+  static void record(Stat stat, uint32_t us) { hist_[(uint8_t)stat].add(us); }
+  static void count(Counter c, uint32_t n) { counter_[(uint8_t)c] += n; }
+
+  static void print();
+  static void reset();
+
+private:
+  static Histogram hist_[(uint8_t)Stat::Count];
+  static uint32_t counter_[(uint8_t)Counter::Count];
+};
+
+  #define STATS_START(var) const uint32_t var = STATS_CLOCK_US()
+  #define STATS_RECORD(stat, us) Stats::record(Stat::stat, (us))
+  #define STATS_SINCE(stat, startUs) Stats::record(Stat::stat, STATS_CLOCK_US() - (startUs))
+  #define STATS_COUNT(counter, n) Stats::count(Counter::counter, (uint32_t)(n))
+
+#else
+
+  #define STATS_START(var)
+  #define STATS_RECORD(stat, us) ((void)0)
+  #define STATS_SINCE(stat, startUs) ((void)0)
+  #define STATS_COUNT(counter, n) ((void)0)
+
+#endif
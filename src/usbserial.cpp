@@ -4,6 +4,9 @@
 #include <cstdio>
 #include <cstring>
 
+#include "frame.h"
+#include "stats.h"
+
 #ifndef SERIAL_BAUDRATE
   #define SERIAL_BAUDRATE 250000
 #endif
@@ -13,9 +16,25 @@
 #endif
 
 void UsbSerial::resetRx_() {
-  lineLen_ = 0;
-  lineReady_ = false;
-  lineBuf_[0] = '\0';
+  // count complete records thrown away unread, the same way nextRecord_() splits them:
+  // empty ones (the LF of a CRLF) and the tail of an overflowed line are not records
+  bool inRecord = false;
+  bool discard = rxDiscard_;
+  for (uint32_t i = peeked_ ? peekEnd_ : rxTail_; i != rxHead_; i++) {
+    const uint8_t c = rx_[i & RX_MASK];
+    if (framed_ ? (c == 0) : (c == '\n' || c == '\r')) {
+      if (inRecord && !discard) rxDropped_++;
+      inRecord = false;
+      discard = false;
+    } else {
+      inRecord = true;
+    }
+  }
+
+  rxHead_ = rxTail_ = rxScan_ = 0;
+  rxDiscard_ = false;
+  rxSkipLf_ = false;
+  peeked_ = false;
 }
 
 bool UsbSerial::cdcOpenNow_() {
@@ -47,6 +66,7 @@ void UsbSerial::close() {
   cdcOpen_ = false;
   connectFired_ = false;
   resetRx_();
+  framed_ = false;
   Serial.end();
 }
 
@@ -68,70 +88,294 @@ void UsbSerial::tick() {
   if (!nowOpen && cdcOpen_) {
     connectFired_ = false;
     resetRx_();
+    framed_ = false;
   }
   cdcOpen_ = nowOpen;
 
-  // Non-blocking RX line accumulation
-  while (Serial.available() && !lineReady_) {
-    int ci = Serial.read();
-    if (ci < 0) break;
-    char c = (char)ci;
+  pumpRx_();
+}
+
+void UsbSerial::pumpRx_() {
+#if defined(ARDUINO_ARCH_RP2040)
+  if (!tud_mounted()) return;
+#endif
+
+  // take everything the endpoint has, up to the free space in the ring
+  for (;;) {
+    const uint32_t space = RX_RING_SIZE - (rxHead_ - rxTail_);
+    const int avail = Serial.available();
+    if (space == 0 || avail <= 0) break;
 
-    // EOL on CR or LF; swallow LF after CR (CRLF)
-    if (c == '\r' || c == '\n') {
-      lineBuf_[lineLen_] = '\0';
-      lineReady_ = true;
+    const uint32_t off = rxHead_ & RX_MASK;
+    size_t chunk = RX_RING_SIZE - off; // contiguous part
+    if (chunk > space) chunk = space;
+    if (chunk > (size_t)avail) chunk = (size_t)avail;
 
-      if (c == '\r' && Serial.available() && Serial.peek() == '\n') {
-        (void)Serial.read();
+    const size_t n = Serial.readBytes(reinterpret_cast<char*>(&rx_[off]), chunk);
+    if (n == 0) break;
+    rxHead_ += n;
+    STATS_COUNT(RxBytes, n);
+  }
+}
+
+bool UsbSerial::nextRecord_(uint8_t** data, size_t* len) {
+  if (peeked_) {
+    *data = peekData_;
+    *len = peekLen_;
+    return true;
+  }
+
+  // "PROTO BIN\r\n" ends at the CR; its LF (maybe not even here yet) would start the first frame
+  if (rxSkipLf_ && rxTail_ != rxHead_) {
+    rxSkipLf_ = false;
+    if (rx_[rxTail_ & RX_MASK] == '\n') rxScan_ = ++rxTail_;
+  }
+
+  for (;;) {
+    bool found = false;
+    while (rxScan_ != rxHead_) {
+      const uint8_t c = rx_[rxScan_ & RX_MASK];
+      if (framed_ ? (c == 0) : (c == '\r' || c == '\n')) {
+        found = true;
+        break;
       }
-      break;
+      rxScan_++;
+
+      if (rxDiscard_) {
+        rxTail_ = rxScan_; // garbage, free the space right away
+      } else if (rxScan_ - rxTail_ >= LINE_BUF_SIZE) {
+        rxDiscard_ = true; // overflow -> drop line
+        rxOverflows_++;
+        rxTail_ = rxScan_;
+      }
+    }
+    if (!found) return false;
+
+    const uint32_t start = rxTail_;
+    const size_t n = rxScan_ - rxTail_;
+    const uint32_t end = rxScan_ + 1; // past the delimiter
+
+    // tail of an overflowed record, or an empty line (LF of CRLF)
+    if (rxDiscard_ || n == 0) {
+      rxDiscard_ = false;
+      rxTail_ = rxScan_ = end;
+      continue;
     }
 
-    if (lineLen_ + 1 < LINE_BUF_SIZE) {
-      lineBuf_[lineLen_++] = c;
+    const uint32_t off = start & RX_MASK;
+    uint8_t* p;
+    if (off + n < RX_RING_SIZE) {
+      p = &rx_[off]; // delimiter sits right behind the record
     } else {
-      resetRx_(); // overflow -> drop line
+      const size_t first = RX_RING_SIZE - off;
+      memcpy(scratch_, &rx_[off], first);
+      memcpy(scratch_ + first, rx_, n - first);
+      p = scratch_;
     }
+    p[n] = '\0';
+
+    rxScan_ = end;
+    peekData_ = p;
+    peekLen_ = n;
+    peekEnd_ = end;
+    peeked_ = true;
+
+    *data = p;
+    *len = n;
+    return true;
   }
 }
 
+bool UsbSerial::peekLine(char** line, size_t* len) {
+  if (framed_ || !line || !len) return false;
+
+  uint8_t* data = nullptr;
+  if (!nextRecord_(&data, len)) {
+    pumpRx_();
+    if (!nextRecord_(&data, len)) return false;
+  }
+  *line = reinterpret_cast<char*>(data);
+  return true;
+}
+
+void UsbSerial::consumeLine() {
+  if (!peeked_) return;
+  rxTail_ = peekEnd_;
+  peeked_ = false;
+}
+
 bool UsbSerial::readLine(char* out, size_t outSize) {
-  if (!lineReady_) return false;
   if (!out || outSize == 0) return false;
 
-  size_t n = strnlen(lineBuf_, LINE_BUF_SIZE);
+  char* line = nullptr;
+  size_t n = 0;
+  if (!peekLine(&line, &n)) return false;
   if (n >= outSize) n = outSize - 1;
 
-  memcpy(out, lineBuf_, n);
+  memcpy(out, line, n);
   out[n] = '\0';
 
-  resetRx_();
+  consumeLine();
   return true;
 }
 
-void UsbSerial::println(const char* s) {
+void UsbSerial::setFramed(bool on) {
+  if (framed_ == on) return;
+  framed_ = on;
+
+  // re-split whatever follows the current record with the new delimiter
+  rxDiscard_ = false;
+  if (!peeked_) rxScan_ = rxTail_;
+
+  // rxTail_ sits right past the delimiter of the line that switched
+  rxSkipLf_ = on && !peeked_ && rxTail_ != 0 && rx_[(rxTail_ - 1) & RX_MASK] == '\r';
+
+  // lone delimiter: lets the host drop whatever text preceded the first frame
+  if (on) {
+    static const uint8_t delim = 0;
+    txAppend_(&delim, 1);
+  }
+}
+
+bool UsbSerial::readFrame(uint8_t* out, size_t outSize, size_t* len) {
+  if (!framed_ || !out || !len) return false;
+
+  uint8_t* data = nullptr;
+  size_t n = 0;
+  if (!nextRecord_(&data, &n)) {
+    pumpRx_();
+    if (!nextRecord_(&data, &n)) return false;
+  }
+
+  *len = Frame::decode(data, n, out, outSize);
+  if (*len == 0) badFrames_++;
+
+  consumeLine();
+  return true;
+}
+
+void UsbSerial::writeFrame(const uint8_t* payload, size_t len) {
+  if (len > Frame::MAX_PAYLOAD) {
+    txDropped_++;
+    return;
+  }
+
+  uint8_t buf[Frame::maxEncoded(Frame::MAX_PAYLOAD) + 1];
+  size_t n = Frame::encode(payload, len, buf);
+  buf[n++] = 0;
+  txAppend_(buf, n);
+}
+
+// --- TX: everything is staged here and leaves in one write + flush per loop pass ---
+
+static constexpr size_t TX_RING_SIZE = 2048; // power of two, holds a full CONFIG dump
+static constexpr uint32_t TX_MASK = TX_RING_SIZE - 1;
+static_assert((TX_RING_SIZE & TX_MASK) == 0, "TX ring must be a power of two");
+
+static uint8_t txRing[TX_RING_SIZE];
+static uint32_t txHead = 0; // free-running
+static uint32_t txTail = 0;
+
+uint32_t UsbSerial::txDropped_ = 0;
+
+bool UsbSerial::txAppend_(const void* data, size_t len) {
 #if defined(ARDUINO_ARCH_RP2040)
-  if (!tud_mounted()) return;
+  if (!tud_mounted()) {
+    txDropped_++;
+    return false;
+  }
 #endif
-  Serial.println(s);
+
+  // full: push out what the endpoint takes right now, never wait for the host
+  if (TX_RING_SIZE - (txHead - txTail) < len) flush();
+  if (TX_RING_SIZE - (txHead - txTail) < len) {
+    txDropped_++;
+    return false;
+  }
+
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  const uint32_t off = txHead & TX_MASK;
+  const size_t first = (len < TX_RING_SIZE - off) ? len : TX_RING_SIZE - off;
+  memcpy(&txRing[off], p, first);
+  memcpy(txRing, p + first, len - first);
+  txHead += len;
+  return true;
 }
 
-void UsbSerial::println() {
+void UsbSerial::flush() {
+  if (txHead == txTail) return;
+
 #if defined(ARDUINO_ARCH_RP2040)
-  if (!tud_mounted()) return;
+  if (!tud_mounted()) {
+    txTail = txHead; // nobody to send to
+    return;
+  }
 #endif
-  Serial.println();
+
+  bool wrote = false;
+  while (txHead != txTail) {
+    const int room = Serial.availableForWrite();
+    if (room <= 0) break;
+
+    const uint32_t off = txTail & TX_MASK;
+    size_t chunk = txHead - txTail;
+    if (chunk > TX_RING_SIZE - off) chunk = TX_RING_SIZE - off; // contiguous part
+    if (chunk > (size_t)room) chunk = (size_t)room;
+
+    const size_t n = Serial.write(&txRing[off], chunk);
+    if (n == 0) break;
+    txTail += n;
+    STATS_COUNT(TxBytes, n);
+    wrote = true;
+  }
+
+  if (wrote) Serial.flush();
 }
 
-void UsbSerial::printf(const char* fmt, ...) {
+size_t UsbSerial::txPending() {
+  return txHead - txTail;
+}
+
+size_t UsbSerial::txFree() {
+  return TX_RING_SIZE - (txHead - txTail);
+}
+
+bool UsbSerial::rxPending() {
 #if defined(ARDUINO_ARCH_RP2040)
-  if (!tud_mounted()) return;
+  if (!tud_mounted()) return false;
 #endif
-  char buf[256];
+  return Serial.available() > 0;
+}
+
+void UsbSerial::println(const char* s) {
+  const size_t n = strlen(s);
+  char buf[LINE_BUF_SIZE + 2];
+  if (n + 2 > sizeof(buf)) {
+    txAppend_(s, n);
+    txAppend_("\r\n", 2);
+    return;
+  }
+  memcpy(buf, s, n);
+  buf[n] = '\r';
+  buf[n + 1] = '\n';
+  txAppend_(buf, n + 2);
+}
+
+void UsbSerial::println() {
+  txAppend_("\r\n", 2);
+}
+
+void UsbSerial::printf(const char* fmt, ...) {
   va_list ap;
   va_start(ap, fmt);
-  vsnprintf(buf, sizeof(buf), fmt, ap);
+  vprintf(fmt, ap);
   va_end(ap);
-  Serial.print(buf);
+}
+
+void UsbSerial::vprintf(const char* fmt, va_list ap) {
+  char buf[256];
+  int n = vsnprintf(buf, sizeof(buf), fmt, ap);
+  if (n < 0) return;
+  if ((size_t)n >= sizeof(buf)) n = sizeof(buf) - 1;
+  txAppend_(buf, (size_t)n);
 }
@@ -1,11 +1,14 @@
 #pragma once
 #include <Arduino.h>
+#include <cstdarg>
 #include <cstddef>
 
 class UsbSerial {
 public:
     using Callback = void (*)();
 
+    static constexpr size_t LINE_BUF_SIZE = 256; // fits SET_FRAME for 32 buttons
+
     void begin();   // non-blocking
     void close();   // non-blocking
 
@@ -13,24 +16,71 @@ public:
 
     void tick(); // non-blocking
 
-    bool readLine(char* out, size_t outSize); // non-blocking, CR/LF/CRLF
+    // Non-blocking, CR/LF/CRLF, empty lines skipped. Call until false to drain.
+    // peekLine() is zero-copy: the line is NUL-terminated, writable and valid
+    // until consumeLine(). readLine() copies and consumes in one go.
+    bool peekLine(char** line, size_t* len);
+    void consumeLine();
+    bool readLine(char* out, size_t outSize);
+
+    // Binary mode: RX is split on 0x00 and read with readFrame() instead of readLine().
+    // Falls back to text whenever the terminal closes.
+    void setFramed(bool on);
+    bool framed() const { return framed_; }
+    bool readFrame(uint8_t* out, size_t outSize, size_t* len); // payload without crc
+    static void writeFrame(const uint8_t* payload, size_t len);
 
+    uint32_t badFrames() const { return badFrames_; }
+    uint32_t rxOverflows() const { return rxOverflows_; } // too long, discarded
+    uint32_t rxDropped() const { return rxDropped_; }     // complete but never read (port closed)
+
+    // Output is staged in a TX ring and sent by flush(), once per loop pass.
+    // Never blocks: if the ring is still full after a flush attempt the message is dropped.
     static void println(const char* s);
     static void println();
     static void printf(const char* fmt, ...);
+    static void vprintf(const char* fmt, va_list ap);
+    static void flush();
+    static size_t txPending();
+    static size_t txFree(); // what the TX ring takes before the next flush
+    static bool rxPending(); // bytes waiting in the CDC FIFO (RX ring was full)
+    static uint32_t txDropped() { return txDropped_; }
 
 private:
-    static constexpr size_t LINE_BUF_SIZE = 128;
-
     Callback onConnect_ = nullptr;
 
     bool cdcOpen_ = false;      // terminal open (DTR)
     bool connectFired_ = false; // fire onConnect once per open
 
-    char lineBuf_[LINE_BUF_SIZE]{};
-    size_t lineLen_ = 0;
-    bool lineReady_ = false;
+    // Byte ring filled straight from the CDC endpoint; lines/frames are split
+    // lazily in the current mode, so a mode switch applies to the very next byte.
+    static constexpr size_t RX_RING_SIZE = 1024;
+    static constexpr uint32_t RX_MASK = RX_RING_SIZE - 1;
+    static_assert((RX_RING_SIZE & RX_MASK) == 0, "RX ring must be a power of two");
+    static_assert(RX_RING_SIZE > LINE_BUF_SIZE, "RX ring must hold a full line");
+    uint8_t rx_[RX_RING_SIZE]{};
+    uint32_t rxHead_ = 0; // free-running write index
+    uint32_t rxTail_ = 0; // start of the oldest unread record
+    uint32_t rxScan_ = 0; // delimiter search resumes here
+    bool rxDiscard_ = false; // overlong record: skip through the next delimiter
+    bool rxSkipLf_ = false; // just framed: the LF of the switching line's CRLF is still due
+
+    uint8_t scratch_[LINE_BUF_SIZE]{}; // records that wrap around the ring end up here
+    uint8_t* peekData_ = nullptr;
+    size_t peekLen_ = 0;
+    uint32_t peekEnd_ = 0;
+    bool peeked_ = false;
+
+    bool framed_ = false;
+    uint32_t badFrames_ = 0;
+    uint32_t rxOverflows_ = 0;
+    uint32_t rxDropped_ = 0;
 
     void resetRx_();
+    void pumpRx_();
+    bool nextRecord_(uint8_t** data, size_t* len);
+    static uint32_t txDropped_;
+    static bool txAppend_(const void* data, size_t len);
+
     static bool cdcOpenNow_() ;
 };
@@ -0,0 +1,147 @@
+#include "ws2812_pio.h"
+
+#if defined(ARDUINO_ARCH_RP2040)
+
+#include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/pio.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+
+#include "pixel.h"
+
+// pico-examples ws2812.pio: 10 PIO cycles per bit (T1=2, T2=5, T3=3), side-set drives the pin
+//   bitloop: out x, 1       side 0 [2]
+//            jmp !x do_zero side 1 [1]
+//   do_one:  jmp bitloop    side 1 [4]
+//   do_zero: nop            side 0 [4]
+static const uint16_t ws2812Program[] = { 0x6221, 0x1123, 0x1400, 0xa442 };
+static const pio_program_t ws2812 = { ws2812Program, 4, -1 };
+
+static constexpr uint32_t BIT_HZ = 800000;
+static constexpr uint32_t CYCLES_PER_BIT = 10;
+static constexpr uint32_t WORD_US = 30;  // 24 bits at 800 kHz
+static constexpr uint32_t RESET_US = 300; // WS2812B latch (>280 us low)
+static constexpr uint32_t FIFO_WORDS = 8; // joined TX FIFO, still shifting when DMA is done
+
+static PIO pio = nullptr;
+static uint sm = 0;
+static int dmaChannel = -1;
+static uint16_t ledCount = 0;
+
+static uint32_t frames[2][Ws2812Pio::MAX_LEDS];
+static volatile int8_t onWire = -1;  // buffer being sent or latching, -1 = idle
+static volatile int8_t pending = -1; // packed buffer waiting for the line
+
+// onLatched() runs on whichever core owns the default alarm pool, show() and the DMA IRQ on the
+// LED core (core 1 with LED_CORE1), so masking interrupts alone doesn't keep them apart
+static spin_lock_t* handoff = nullptr;
+
+static void startFrame(int8_t buf)
+{
+  onWire = buf;
+  dma_channel_transfer_from_buffer_now(dmaChannel, frames[buf], ledCount);
+}
+
+static int64_t onLatched(alarm_id_t, void*)
+{
+  const uint32_t irq = spin_lock_blocking(handoff);
+  onWire = -1;
+  if (pending >= 0) {
+    const int8_t next = pending;
+    pending = -1;
+    startFrame(next);
+  }
+  spin_unlock(handoff, irq);
+  return 0; // one-shot
+}
+
+static void onDmaDone()
+{
+  if (!dma_channel_get_irq0_status(dmaChannel)) return; // shared IRQ, not ours
+  dma_channel_acknowledge_irq0(dmaChannel);
+
+  // the FIFO still drains after the last word was taken, then the line has to stay low
+  if (add_alarm_in_us((FIFO_WORDS + 1) * WORD_US + RESET_US, onLatched, nullptr, true) < 0) {
+    const uint32_t irq = spin_lock_blocking(handoff);
+    onWire = -1; // no alarm slot: the next show() starts it, a tad early at worst
+    spin_unlock(handoff, irq);
+  }
+}
+
+bool Ws2812Pio::init(uint8_t pin, uint16_t count)
+{
+  if (count > MAX_LEDS) return false;
+  ledCount = count;
+
+  // claim everything before touching the pin, so a failure leaves it to the FastLED fallback
+  const int lockNum = spin_lock_claim_unused(false);
+  if (lockNum < 0) return false;
+  pio = pio_can_add_program(pio0, &ws2812) ? pio0 : pio1;
+  const int claimed = pio_can_add_program(pio, &ws2812) ? pio_claim_unused_sm(pio, false) : -1;
+  if (claimed < 0) {
+    spin_lock_unclaim((uint)lockNum);
+    return false;
+  }
+  dmaChannel = dma_claim_unused_channel(false);
+  if (dmaChannel < 0) {
+    pio_sm_unclaim(pio, (uint)claimed);
+    spin_lock_unclaim((uint)lockNum);
+    return false;
+  }
+
+  handoff = spin_lock_init((uint)lockNum);
+  sm = (uint)claimed;
+  const uint offset = pio_add_program(pio, &ws2812);
+
+  pio_gpio_init(pio, pin);
+  pio_sm_set_consecutive_pindirs(pio, sm, pin, 1, true);
+
+  pio_sm_config c = pio_get_default_sm_config();
+  sm_config_set_wrap(&c, offset, offset + 3);
+  sm_config_set_sideset(&c, 1, false, false);
+  sm_config_set_sideset_pins(&c, pin);
+  sm_config_set_out_shift(&c, false, true, 24); // MSB first, autopull every 24 bits
+  sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_TX);
+  sm_config_set_clkdiv(&c, (float)clock_get_hz(clk_sys) / (float)(BIT_HZ * CYCLES_PER_BIT));
+  pio_sm_init(pio, sm, offset, &c);
+  pio_sm_set_enabled(pio, sm, true);
+
+  dma_channel_config dc = dma_channel_get_default_config(dmaChannel);
+  channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+  channel_config_set_read_increment(&dc, true);
+  channel_config_set_write_increment(&dc, false);
+  channel_config_set_dreq(&dc, pio_get_dreq(pio, sm, true));
+  dma_channel_configure(dmaChannel, &dc, &pio->txf[sm], frames[0], count, false);
+
+  dma_channel_set_irq0_enabled(dmaChannel, true);
+  irq_add_shared_handler(DMA_IRQ_0, onDmaDone, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+  irq_set_enabled(DMA_IRQ_0, true);
+  return true;
+}
+
+void Ws2812Pio::show(const CRGB* leds)
+{
+  if (dmaChannel < 0) return;
+
+  // take back a frame that hasn't started yet, the one on the wire is never touched
+  uint32_t irq = spin_lock_blocking(handoff);
+  pending = -1;
+  const int8_t buf = onWire == 0 ? 1 : 0;
+  spin_unlock(handoff, irq);
+
+  Pixel::packFrame(leds, ledCount, frames[buf]);
+
+  irq = spin_lock_blocking(handoff);
+  if (onWire < 0) startFrame(buf);
+  else pending = buf;
+  spin_unlock(handoff, irq);
+}
+
+bool Ws2812Pio::busy()
+{
+  return onWire >= 0;
+}
+
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+#include <Arduino.h>
+
+#include "FastLED.h"
+
+#if defined(ARDUINO_ARCH_RP2040)
+
+// WS2812 output through a PIO state machine fed by DMA. show() packs the frame into whichever
+// of two word buffers is not on the wire and returns; the DMA IRQ plus a latch alarm start the
+// next pending frame, so LED count no longer costs CPU time.
+class Ws2812Pio {
+public:
+  static constexpr uint16_t MAX_LEDS = 256;
+
+  static bool init(uint8_t pin, uint16_t count); // false if no PIO/DMA/spin lock is free
+  static void show(const CRGB* leds);            // latest frame wins while one is still going out
+  static bool busy();                            // a frame is on the wire or latching
+};
+
+#endif